@@ -1,32 +1,72 @@
+#include <iostream>
+
 #include <gflags/gflags.h>
 
 #include <FileIO/BinaryIO.h>
 #include <FileIO/PlyIO.h>
-#include <Geometry/Point.h>
+#include <FileIO/PointRecords.h>
+#include <Geometry/PointCloud.h>
 
 DEFINE_string(bin_file, "", "required");
 DEFINE_string(ply_file, "", "required");
+DEFINE_string(record, "float", "records of the bin file: float (15 byte xyz rgb records) or aligned (16 byte xyz rgba records)");
+
+namespace {
+
+const uint8_t* Rgb(const point_records::XyzRgb& record) {
+	return record.rgb.data();
+}
+
+const uint8_t* Rgb(const point_records::XyzRgba& record) {
+	return record.rgba.data();
+}
+
+///
+/// Reads all records of the file into the point cloud. Returns false if the file size is not a multiple of the record size.
+///
+template <typename Record>
+bool ReadRecords(
+	binary_io::BufferedBinaryReader* const bin,
+	geometry::PointCloud<float>* const points
+	) {
+	if(bin->FileSize() % sizeof(Record) != 0) {
+		std::cerr << FLAGS_bin_file << " is not a file of " << sizeof(Record) << " byte records" << std::endl;
+		return false;
+	}
+	std::vector<Record> records(bin->FileSize() / sizeof(Record));
+	records.resize(bin->ReadSpan(records.data(), records.size()));
+
+	points->EnableColors();
+	points->Resize(records.size());
+	for(size_t i = 0; i < records.size(); ++i) {
+		const uint8_t* const rgb = Rgb(records[i]);
+		points->X()[i] = records[i].xyz[0];
+		points->Y()[i] = records[i].xyz[1];
+		points->Z()[i] = records[i].xyz[2];
+		points->Colors()[i] = {{rgb[0], rgb[1], rgb[2]}};
+	}
+	return true;
+}
+
+} // namespace
 
 int main(int argc, char* argv[]) {
     gflags::ParseCommandLineFlags(&argc, &argv, true);
 
-	binary_io::BinaryReader bin(FLAGS_bin_file);
-	std::vector<geometry::Point<float>> all_points_color;
-	while(true) {
-		geometry::Point<float> p;
-		bool ok = true;
-		ok = ok && bin.Read<float>(&p.xyz_(0));
-		ok = ok && bin.Read<float>(&p.xyz_(1));
-		ok = ok && bin.Read<float>(&p.xyz_(2));
-		ok = ok && bin.Read<uint8_t>(&p.c_[0]);
-		ok = ok && bin.Read<uint8_t>(&p.c_[1]);
-		ok = ok && bin.Read<uint8_t>(&p.c_[2]);
-		p.c_[3] = 255;
-		if(!ok)
-			break;
-		all_points_color.push_back(p);
+	binary_io::BufferedBinaryReader bin(FLAGS_bin_file);
+	geometry::PointCloud<float> all_points_color;
+	bool read = false;
+	if(FLAGS_record == "float") {
+		read = ReadRecords<point_records::XyzRgb>(&bin, &all_points_color);
+	} else if(FLAGS_record == "aligned") {
+		read = ReadRecords<point_records::XyzRgba>(&bin, &all_points_color);
+	} else {
+		std::cerr << "unknown record " << FLAGS_record << std::endl;
+		return 1;
 	}
+	if(!read)
+		return 1;
 	ply_io::PlyIO<float>::WritePly(FLAGS_ply_file, all_points_color);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -2,18 +2,39 @@
 #include <unordered_map>
 #include <algorithm>
 #include <random>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
 #include <filesystem>
+#include <omp.h>
 
 #include <gflags/gflags.h>
 
-#include <FileIO/BinaryIO.h>
-#include <FileIO/PlyIO.h>
+#include <FileIO/PointReader.h>
+#include <FileIO/PointRecords.h>
+#include <FileIO/OctreeLayout.h>
+#include <FileIO/OctreeReader.h>
+#include <FileIO/OctreeWriter.h>
+#include <FileIO/BlockCodec.h>
 #include <VoxelMap/VoxelMapAveraging.h>
 #include <VoxelMap/KeyGenerate.h>
+#include <Geometry/PointCloud.h>
 
-DEFINE_string(input_ply_file, "", "required");
+DEFINE_string(input_ply_file, "", "required, a LAS file, a binary PCD file, a binary or ASCII PLY file or a text file with a point per line (xyz, csv, pts)");
 DEFINE_string(output_octree_file, "", "required");
-DEFINE_string(cache_folder, "", "required");
+DEFINE_string(cache_folder, "", "unused, the chunks are passed from the partitioning to the voxelization in memory");
+DEFINE_string(encoding, "quantized", "encoding of the block payloads: quantized (9 byte records), float (15 byte records) or aligned (16 byte records). "
+	"the default used to be float, pass --encoding=float for the previous output format");
+DEFINE_bool(compress, false, "losslessly compress the block payloads, requires the quantized encoding. "
+	"the points of compressed blocks are stored in spatial (Morton) order instead of the structured random order");
+DEFINE_string(block_layout, "grouped", "order of the blocks in the output file: grouped or interleaved (see Repack) rewrite the file in "
+	"Morton order once all blocks are written, finish keeps the order in which the chunks finish and skips the rewrite");
+DEFINE_uint64(ingest_threads, 0, "threads reading and partitioning the input, 0 uses all cores");
+DEFINE_uint64(voxelize_threads, 0, "threads building and encoding the blocks, 0 uses all cores");
+DEFINE_uint64(write_queue_mb, 256, "encoded blocks waiting for the writer thread before the encoding threads wait for it");
 
 namespace {
 
@@ -76,34 +97,137 @@ private:
 };
 
 ///
-/// Class that converts a ply file to a viewer-compatible octree file.
+/// Hands the encoded blocks of the chunks to a writer thread through a queue bounded in bytes.
+/// Encoding does not wait for the disk until the queue is full, then the encoding threads wait for the writer.
 ///
-class Converter {
+class BlockWriteQueue {
 public:
+	BlockWriteQueue(
+		octree_writer::OctreeWriter* const writer,
+		const size_t max_bytes
+		) : writer_(writer), max_bytes_(max_bytes) {
+		thread_.reset(new std::thread(&BlockWriteQueue::WriteLoop, this));
+	}
+
+	~BlockWriteQueue() {
+		Finish();
+	}
+
+	BlockWriteQueue(const BlockWriteQueue&) = delete;
+	BlockWriteQueue& operator=(const BlockWriteQueue&) = delete;
+
 	///
-	/// Step that uses voxelmaps to create the various files for the various levels of the octree.
+	/// Queues the blocks, whose payloads are concatenated in data, and waits while the queue is full.
+	/// Blocks larger than the queue are accepted once the queue is empty. Safe to call from multiple threads.
 	///
-	static void CreateHashedFiles(
-			const std::string& ply_file,
-			const std::string& cache_folder,
-			const size_t level_to_become_level_zero,
-			const size_t num_levels
+	void Push(
+		std::vector<octree_layout::BlockEntry>&& blocks,
+		std::vector<uint8_t>&& data
 		) {
-		const std::vector<std::string> in_files = {
-			ply_file
-		};
-
-		const std::vector<std::string> out_folders = {
-			cache_folder + (cache_folder.back() != '/' ? "/" : "") + "octree_hash_files/"
-		};
-
-		for(const std::string& f : out_folders) {
-			if(std::filesystem::exists(f))
-				std::filesystem::remove_all(f);
-			std::filesystem::create_directories(f);
+		std::unique_lock<std::mutex> lock(mutex_);
+		not_full_cv_.wait(lock, [&]() {
+			return queued_bytes_ == 0 || queued_bytes_ + data.size() <= max_bytes_;
+		});
+		queued_bytes_ += data.size();
+		queue_.push_back({std::move(blocks), std::move(data)});
+		not_empty_cv_.notify_one();
+	}
+
+	///
+	/// Waits until all queued blocks are written. Returns false if a write failed.
+	///
+	bool Finish() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			finished_ = true;
 		}
+		not_empty_cv_.notify_one();
+		if(thread_ != nullptr && thread_->joinable())
+			thread_->join();
+		return good_;
+	}
 
+private:
+	struct QueuedBlocks {
+		std::vector<octree_layout::BlockEntry> blocks;
+		std::vector<uint8_t> data;
+	};
+
+	void WriteLoop() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while(true) {
+			not_empty_cv_.wait(lock, [&]() {
+				return !queue_.empty() || finished_;
+			});
+			if(queue_.empty())
+				return;
+			const QueuedBlocks queued = std::move(queue_.front());
+			queue_.pop_front();
+
+			lock.unlock();
+			if(!writer_->WriteBlocks(queued.blocks, queued.data.data()))
+				good_ = false;
+			lock.lock();
+
+			queued_bytes_ -= queued.data.size();
+			not_full_cv_.notify_all();
+		}
+	}
+
+	octree_writer::OctreeWriter* const writer_;
+	const size_t max_bytes_;
+	std::unique_ptr<std::thread> thread_;
+	std::mutex mutex_;
+	std::condition_variable not_empty_cv_;
+	std::condition_variable not_full_cv_;
+	std::deque<QueuedBlocks> queue_;
+	size_t queued_bytes_ = 0;
+	bool finished_ = false;
+	// only touched by the writer thread until it is joined
+	bool good_ = true;
+};
 
+///
+/// Threads of the converter stages and the size of the queue between the encoding and the writer thread.
+///
+struct StageOptions {
+	size_t ingest_threads = 1;
+	size_t voxelize_threads = 1;
+	size_t write_queue_bytes = 0;
+};
+
+///
+/// Records of a chunk that were read from one range of the input, a span of the records of that range.
+///
+struct ChunkPiece {
+	size_t range = 0;
+	size_t first = 0;
+	size_t size = 0;
+};
+
+///
+/// Class that converts a ply file to a viewer-compatible octree file.
+///
+class Converter {
+public:
+	///
+	/// Uses voxelmaps to create the levels of the octree and writes them straight into the output file.
+	/// The whole input is read and partitioned into chunks first, the chunks are handed to the voxelize threads in
+	/// memory instead of through cache files, and a writer thread writes the encoded blocks from a bounded queue
+	/// while the voxelize threads encode the next ones. Only the encoding and the writing overlap.
+	/// Every chunk reserves one range of the file for all levels of its block, so the levels of a block
+	/// are grouped. The blocks follow the order in which the chunks finish, roughly largest first,
+	/// SortOctree rewrites the file in Morton order.
+	///
+	static bool CreateOctree(
+			const std::string& input_file,
+			const std::string& output_file,
+			const size_t level_to_become_level_zero,
+			const size_t num_levels,
+			const point_records::Encoding encoding,
+			const bool compress,
+			const StageOptions& stage_options
+		) {
 		const size_t chunk_size = 10000;
 		const float level_0_voxel_size = 10.0f;
 		const float structured_random_order_voxel_size = 2.5f;
@@ -114,284 +238,298 @@ public:
 		for(size_t i=1; i < voxel_sizes.size(); ++i)
 			voxel_sizes[i] = 0.5f * voxel_sizes[i-1];
 
-		for(size_t f = 0; f < in_files.size(); ++f) {
-			// first step is to split the big bin file into smaller bin files, each for its own L0
-			const std::string bin_file_chunk_folder = cache_folder + "points_splitting_" + std::to_string(f) + "/";
-			std::unordered_set<int64_t> bin_file_chunk_keys;
+		// first step is to split the input file into chunks, each for its own L0.
+		// the reader splits the file into ranges that are read independently, binary PLY vertices, LAS records and
+		// PCD columns are decoded straight from the mapped file and text files are split at newlines, so the ranges
+		// are read and routed to the chunks in parallel. points are read in double and only become float once they
+		// are centered, so georeferenced coordinates keep their precision.
+		// the input is read twice, once for the centroid and once to route the records, and the voxelization starts
+		// only after the whole file is routed. a chunk is complete only at the end of the input, so voxelizing while
+		// reading would keep the voxel maps of all chunks open until then, and the maps of all levels hold several
+		// voxels per input point at far more than the 16 bytes of a record. so the chunks are kept as records and handed
+		// to the next stage in memory instead of going through the disk. the records stay in the arrays of the ranges
+		// they were read from, a chunk is the list of its pieces in them, and the array of a range is freed when all
+		// its chunks are inserted
+		const int ingest_threads = static_cast<int>(stage_options.ingest_threads);
+		std::vector<std::vector<point_records::XyzRgba>> range_records;
+		std::unordered_map<int64_t, std::vector<ChunkPiece>> chunk_pieces;
+		std::unique_ptr<std::atomic<size_t>[]> range_num_chunks;
+		{
+			const std::unique_ptr<point_reader::PointReader<double>> reader = point_reader::OpenPointReader<double>(input_file);
+			if(reader == nullptr) {
+				std::cerr << "could not read " << input_file << std::endl;
+				return false;
+			}
+			const size_t num_ranges = reader->NumRanges();
+
+			// the centroid is a parallel reduction, the per range sums are added up in range order
+			// so the result does not depend on the number of threads
+			std::vector<Eigen::Matrix<double, 3, 1>> range_sums(num_ranges, Eigen::Matrix<double, 3, 1>::Zero());
+			std::vector<size_t> range_sizes(num_ranges, 0);
+			// set by several threads, so it is atomic
+			std::atomic<bool> ok{true};
+			#pragma omp parallel num_threads(ingest_threads)
 			{
-				if(std::filesystem::exists(bin_file_chunk_folder))
-					std::filesystem::remove_all(bin_file_chunk_folder);
-				std::filesystem::create_directory(bin_file_chunk_folder);
-				
-				std::vector<geometry::Point<float>> points;
-				ply_io::PlyIO<float>::ReadPly(in_files[f], &points);
-
-				Eigen::Matrix<double, 3, 1> average_xyz_double = Eigen::Matrix<double, 3, 1>::Zero();
-				double num_samples = 0.0;
-				for(const geometry::Point<float>& point : points) {
-					++num_samples;
-					average_xyz_double += (point.Cast<double>().xyz_.block<3,1>(0,0) - average_xyz_double) / num_samples;
+				geometry::PointCloud<double> range_points;
+				#pragma omp for schedule(static)
+				for(size_t r = 0; r < num_ranges; ++r) {
+					if(!reader->ReadRange(r, &range_points)) {
+						ok = false;
+						continue;
+					}
+					double sum_x = 0.0, sum_y = 0.0, sum_z = 0.0;
+					for(size_t i = 0; i < range_points.Size(); ++i) {
+						sum_x += range_points.X()[i];
+						sum_y += range_points.Y()[i];
+						sum_z += range_points.Z()[i];
+					}
+					range_sums[r] = Eigen::Matrix<double, 3, 1>(sum_x, sum_y, sum_z);
+					range_sizes[r] = range_points.Size();
 				}
-				const Eigen::Matrix<float, 3, 1> average_xyz_float = average_xyz_double.cast<float>();
-
-				for(geometry::Point<float>& point : points)
-					point.xyz_.block<3,1>(0,0) -= average_xyz_float;
-
-				for(const geometry::Point<float>& point : points) {
-					const int64_t key = key_gen.GetVoxelId(point.xyz_);
-					bin_file_chunk_keys.insert(key);
-					binary_io::BinaryWriter writer_append(bin_file_chunk_folder + std::to_string(key) + ".bin", true);
-					writer_append.Write<float>(point.xyz_(0));
-					writer_append.Write<float>(point.xyz_(1));
-					writer_append.Write<float>(point.xyz_(2));
-					writer_append.Write<uint8_t>(point.c_[0]);
-					writer_append.Write<uint8_t>(point.c_[1]);
-					writer_append.Write<uint8_t>(point.c_[2]);
+			}
+			if(!ok) {
+				std::cerr << "could not read " << input_file << std::endl;
+				return false;
+			}
+			Eigen::Matrix<double, 3, 1> sum_xyz = Eigen::Matrix<double, 3, 1>::Zero();
+			size_t num_points = 0;
+			for(size_t r = 0; r < num_ranges; ++r) {
+				sum_xyz += range_sums[r];
+				num_points += range_sizes[r];
+			}
+			const Eigen::Matrix<double, 3, 1> average_xyz = num_points > 0
+				? Eigen::Matrix<double, 3, 1>(sum_xyz / static_cast<double>(num_points))
+				: Eigen::Matrix<double, 3, 1>::Zero();
+
+			// every range is read once more and sorts its records by chunk into an array of the exact size, so the
+			// records are routed without locking and without copying them again. the pieces of a chunk are in range
+			// order, so the chunks are in file order and do not depend on the number of threads
+			range_records.resize(num_ranges);
+			std::vector<std::vector<std::pair<int64_t, ChunkPiece>>> range_pieces(num_ranges);
+			#pragma omp parallel num_threads(ingest_threads)
+			{
+				geometry::PointCloud<double> range_points;
+				std::vector<int64_t> keys;
+				std::vector<point_records::XyzRgba> unsorted;
+				std::unordered_map<int64_t, size_t> chunk_fill;
+				#pragma omp for schedule(static)
+				for(size_t r = 0; r < num_ranges; ++r) {
+					if(!reader->ReadRange(r, &range_points)) {
+						ok = false;
+						continue;
+					}
+					keys.resize(range_points.Size());
+					unsorted.resize(range_points.Size());
+					chunk_fill.clear();
+					for(size_t i = 0; i < range_points.Size(); ++i) {
+						const float x = static_cast<float>(range_points.X()[i] - average_xyz(0));
+						const float y = static_cast<float>(range_points.Y()[i] - average_xyz(1));
+						const float z = static_cast<float>(range_points.Z()[i] - average_xyz(2));
+						const std::array<uint8_t, 3> rgb = range_points.HasColors() ? range_points.Colors()[i] : std::array<uint8_t, 3>{{0, 0, 0}};
+						keys[i] = key_gen.GetVoxelId(x, y, z);
+						unsorted[i] = {
+							{{x, y, z}},
+							{{rgb[0], rgb[1], rgb[2], 255}}
+						};
+						++chunk_fill[keys[i]];
+					}
+
+					size_t first = 0;
+					for(std::pair<const int64_t, size_t>& chunk : chunk_fill) {
+						range_pieces[r].push_back({chunk.first, {r, first, chunk.second}});
+						first += chunk.second;
+						chunk.second = first - chunk.second;
+					}
+					range_records[r].resize(range_points.Size());
+					for(size_t i = 0; i < range_points.Size(); ++i)
+						range_records[r][chunk_fill[keys[i]]++] = unsorted[i];
 				}
 			}
+			if(!ok) {
+				std::cerr << "could not read " << input_file << std::endl;
+				return false;
+			}
 
-			// second step is to apply voxmaps on the chunks
-			std::vector<int64_t> bin_file_chunk_keys_vector;
-			for(const int64_t key : bin_file_chunk_keys)
-				bin_file_chunk_keys_vector.push_back(key);
+			range_num_chunks.reset(new std::atomic<size_t>[num_ranges]);
+			for(size_t r = 0; r < num_ranges; ++r) {
+				range_num_chunks[r] = range_pieces[r].size();
+				for(const std::pair<int64_t, ChunkPiece>& piece : range_pieces[r])
+					chunk_pieces[piece.first].push_back(piece.second);
+			}
+		}
 
-			#pragma omp parallel for
-			for(size_t i = 0; i < bin_file_chunk_keys_vector.size(); ++i) {
-				const int64_t key = bin_file_chunk_keys_vector[i];
-				binary_io::BinaryReader bin(bin_file_chunk_folder + std::to_string(key) + ".bin");
+		// second step is to apply voxmaps on the chunks and encode their levels, the third writes the blocks.
+		// chunk sizes vary by orders of magnitude, so every chunk is an OpenMP task and the tasks are created largest
+		// first. chunks that hold a large share of the points insert and encode their levels as nested tasks, which the
+		// threads that ran out of chunks pick up, so the stage does not end with one thread working through the largest
+		// chunk alone. the encoded blocks go through a bounded queue to a writer thread, so encoding and writing overlap
+		// and the blocks are placed in the output file in the order the chunks finish, not in Morton order
+		const int voxelize_threads = static_cast<int>(stage_options.voxelize_threads);
+		std::vector<std::pair<int64_t, size_t>> chunks;
+		size_t total_points = 0;
+		for(const std::pair<const int64_t, std::vector<ChunkPiece>>& chunk : chunk_pieces) {
+			size_t num_records = 0;
+			for(const ChunkPiece& piece : chunk.second)
+				num_records += piece.size;
+			chunks.push_back({chunk.first, num_records});
+			total_points += num_records;
+		}
+		std::sort(chunks.begin(), chunks.end(), [](const std::pair<int64_t, size_t>& a, const std::pair<int64_t, size_t>& b) {
+			if(a.second != b.second)
+				return a.second > b.second;
+			return octree_layout::MortonCode(static_cast<uint64_t>(a.first)) < octree_layout::MortonCode(static_cast<uint64_t>(b.first));
+		});
+		const size_t split_levels_points = std::max(4 * chunk_size, total_points / (2 * stage_options.voxelize_threads));
+
+		// every chunk produces one block per output level
+		const size_t num_output_levels = num_levels - level_to_become_level_zero;
+		octree_writer::OctreeWriter octree_writer(output_file, std::vector<size_t>(num_output_levels, chunks.size()));
+		BlockWriteQueue write_queue(&octree_writer, stage_options.write_queue_bytes);
+
+		#pragma omp parallel num_threads(voxelize_threads)
+		#pragma omp single
+		for(size_t c = 0; c < chunks.size(); ++c) {
+			#pragma omp task firstprivate(c)
+			{
+				const int64_t key = chunks[c].first;
+				const bool split_levels = (chunks[c].second >= split_levels_points);
+				const std::vector<ChunkPiece>& pieces = chunk_pieces.at(key);
 
+				// the levels above the new level zero are not written, so they are not built
 				std::vector<std::unique_ptr<voxel_map::VoxelMapAveraging<float>>> voxmaps(num_levels);
-				for(size_t i=0; i < num_levels; ++i)
+				for(size_t i = level_to_become_level_zero; i < num_levels; ++i)
 					voxmaps[i].reset(new voxel_map::VoxelMapAveraging<float>(voxel_sizes[i]));
 
-				std::vector<geometry::Point<float>> insertion_chunk;
-				geometry::Point<float> point;
-				while(
-					bin.Read<float>(&(point.xyz_(0))) 
-					&& bin.Read<float>(&(point.xyz_(1))) 
-					&& bin.Read<float>(&(point.xyz_(2))) 
-					&& bin.Read<uint8_t>(&(point.c_[0])) 
-					&& bin.Read<uint8_t>(&(point.c_[1])) 
-					&& bin.Read<uint8_t>(&(point.c_[2]))
-					) {
-					insertion_chunk.push_back(point);
-					if(insertion_chunk.size() == chunk_size) {
-						for(size_t i=0; i < num_levels; ++i)
-							voxmaps[i]->AddSamples(insertion_chunk);
-						insertion_chunk.clear();
+				// pieces are inserted in file order so the averages do not depend on the number of threads
+				geometry::PointCloud<float> insertion_chunk;
+				insertion_chunk.EnableColors();
+				size_t piece = 0;
+				size_t piece_offset = 0;
+				for(size_t first = 0; first < chunks[c].second; first += chunk_size) {
+					const size_t num_records = std::min(chunk_size, chunks[c].second - first);
+					insertion_chunk.Resize(num_records);
+					for(size_t j = 0; j < num_records; ++j, ++piece_offset) {
+						if(piece_offset == pieces[piece].size) {
+							++piece;
+							piece_offset = 0;
+						}
+						const point_records::XyzRgba& record = range_records[pieces[piece].range][pieces[piece].first + piece_offset];
+						insertion_chunk.X()[j] = record.xyz[0];
+						insertion_chunk.Y()[j] = record.xyz[1];
+						insertion_chunk.Z()[j] = record.xyz[2];
+						insertion_chunk.Colors()[j] = {{record.rgba[0], record.rgba[1], record.rgba[2]}};
 					}
-				}
-				for(size_t i=0; i < num_levels; ++i)
-					voxmaps[i]->AddSamples(insertion_chunk);
-				insertion_chunk.clear();
 
-				// part that writes the bin files
+					#pragma omp taskloop default(shared) grainsize(1) if(split_levels)
+					for(size_t i = level_to_become_level_zero; i < num_levels; ++i)
+						voxmaps[i]->AddSamples(insertion_chunk);
+				}
+				insertion_chunk.Clear();
+				// the last chunk inserted from a range releases its records
+				for(const ChunkPiece& inserted : pieces)
+					if(--range_num_chunks[inserted.range] == 0)
+						std::vector<point_records::XyzRgba>().swap(range_records[inserted.range]);
+
+				// the levels of the block are encoded independently and then written with one reservation
+				const std::array<float, 3> block_origin = octree_layout::BlockOrigin(static_cast<uint64_t>(key), level_0_voxel_size);
+				const size_t record_size = point_records::RecordSize(encoding);
+				std::vector<std::vector<uint8_t>> level_bytes(num_output_levels);
+				std::vector<octree_layout::BlockEntry> block_entries(num_output_levels);
+				#pragma omp taskloop default(shared) grainsize(1) if(split_levels)
 				for(size_t i = level_to_become_level_zero; i < num_levels; ++i) {
 					std::array<std::unique_ptr<std::vector<Eigen::Matrix<float, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 3, 1>>>>, 2> xyz_rgb 
 						= voxmaps[i]->ExtractAllPoints();
+					voxmaps[i].reset();
+
+					std::vector<uint8_t>& bytes = level_bytes[i - level_to_become_level_zero];
+					bytes.reserve(xyz_rgb[0]->size() * record_size);
+					const auto append_record = [&](const std::array<float, 3>& xyz, const std::array<uint8_t, 3>& rgb){
+						const point_records::XyzRgb record{xyz, rgb};
+						bytes.resize(bytes.size() + record_size);
+						if(encoding == point_records::Encoding::kXyzRgbQuantized) {
+							const point_records::XyzRgbQuantized quantized = point_records::Quantize(record, block_origin, level_0_voxel_size);
+							std::memcpy(bytes.data() + bytes.size() - record_size, &quantized, record_size);
+						} else if(encoding == point_records::Encoding::kXyzRgba) {
+							const point_records::XyzRgba aligned{xyz, {{rgb[0], rgb[1], rgb[2], 255}}};
+							std::memcpy(bytes.data() + bytes.size() - record_size, &aligned, record_size);
+						} else {
+							std::memcpy(bytes.data() + bytes.size() - record_size, &record, record_size);
+						}
+					};
+
+					if(compress) {
+						// the codec stores the records in Morton order, a structured random order would be lost anyway
+						for(size_t j=0; j < xyz_rgb[0]->size(); ++j) {
+							append_record({{
+								xyz_rgb[0]->at(j)(0),
+								xyz_rgb[0]->at(j)(1),
+								xyz_rgb[0]->at(j)(2)
+							}}, {{
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(0)),
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(1)),
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(2))
+							}});
+						}
+					} else {
+						StructuredRandomOrder structured_random_ordering(structured_random_order_voxel_size);
+						for(size_t j=0; j < xyz_rgb[0]->size(); ++j) {
+							structured_random_ordering.Insert({{
+								xyz_rgb[0]->at(j)(0),
+								xyz_rgb[0]->at(j)(1),
+								xyz_rgb[0]->at(j)(2)
+							}, {
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(0)),
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(1)),
+								static_cast<uint8_t>(xyz_rgb[1]->at(j)(2))
+							}});
+						}
+						structured_random_ordering.Shuffle();
+						structured_random_ordering.ExtractPoints(append_record);
+					}
 
-					StructuredRandomOrder structured_random_ordering(structured_random_order_voxel_size);
-					for(size_t j=0; j < xyz_rgb[0]->size(); ++j) {
-						structured_random_ordering.Insert({{
-							xyz_rgb[0]->at(j)(0),
-							xyz_rgb[0]->at(j)(1),
-							xyz_rgb[0]->at(j)(2)
-						}, {
-							static_cast<uint8_t>(xyz_rgb[1]->at(j)(0)),
-							static_cast<uint8_t>(xyz_rgb[1]->at(j)(1)),
-							static_cast<uint8_t>(xyz_rgb[1]->at(j)(2))
-						}});
+					octree_layout::BlockEntry& block_entry = block_entries[i - level_to_become_level_zero];
+					block_entry.level = i - level_to_become_level_zero;
+					block_entry.hash = static_cast<uint64_t>(key);
+					block_entry.size = bytes.size();
+					block_entry.encoding = encoding;
+					if(compress) {
+						std::vector<uint8_t> compressed_bytes;
+						block_codec::Compress(bytes.data(), block_entry.size, &compressed_bytes);
+						bytes = std::move(compressed_bytes);
+						block_entry.codec = block_codec::Codec::kMortonDeltaRans;
+						block_entry.decoded_size = block_entry.size;
+						block_entry.size = bytes.size();
 					}
-					structured_random_ordering.Shuffle();
-
-					binary_io::BinaryWriter writer(out_folders[f] + std::to_string(i - level_to_become_level_zero) + std::to_string(key) + ".bin");
-					structured_random_ordering.ExtractPoints([&](std::array<float, 3> xyz, std::array<uint8_t, 3> rgb){
-						writer.Write<float>(xyz[0]);
-						writer.Write<float>(xyz[1]);
-						writer.Write<float>(xyz[2]);
-						writer.Write<uint8_t>(rgb[0]);
-						writer.Write<uint8_t>(rgb[1]);
-						writer.Write<uint8_t>(rgb[2]);
-					});
 				}
-			}
-		}
-	}
-
-	///
-	/// Generates single file from the individual octree files in the cache.
-	///
-	static void FileBundling(
-		const std::string& cache_folder,
-		const std::string& output_file,
-		const size_t num_levels
-		) {
-		const std::string octree_dir = cache_folder + (cache_folder.back() != '/' ? "/" : "") + "octree_hash_files/";
-		binary_io::BinaryWriter bin_writer(output_file);
-
-		std::vector<std::string> octree_bin_files;
-		GetDirFilesWithExtention(octree_dir, ".bin", &octree_bin_files);
-
-		std::vector<std::unordered_map<uint64_t, size_t>> relative_file_offsets(num_levels);
-		std::vector<std::unordered_map<uint64_t, size_t>> file_sizes(num_levels);
-		size_t relative_total_size = 0;
-
-		for(const std::string& bin : octree_bin_files) {
-			const std::string bin_path = octree_dir + "/" + bin;
-			const size_t level = GetIntsFromString(bin.substr(0,1))[0];
-			const uint64_t hash = GetIntsFromString(bin.substr(1))[0];
 
-			relative_file_offsets[level].insert({hash, relative_total_size});
-			const size_t this_file_size = std::filesystem::file_size(bin_path);
-			relative_total_size += this_file_size;
-			file_sizes[level].insert({hash, this_file_size});
-		}
-
-		size_t octree_header_size = 0;
-		for(size_t j=0; j < num_levels; ++j) {
-			octree_header_size += sizeof(size_t);
-			octree_header_size += relative_file_offsets[j].size() * sizeof(uint64_t);
-			octree_header_size += relative_file_offsets[j].size() * sizeof(size_t);
-			octree_header_size += relative_file_offsets[j].size() * sizeof(size_t);
-		}
-
-		size_t total_size = 0;
-		for(size_t j=0; j < num_levels; ++j) {
-			bin_writer.Write<size_t>(relative_file_offsets[j].size());
-			for(const auto& a : relative_file_offsets[j]) {
-				bin_writer.Write<uint64_t>(a.first);
-				bin_writer.Write<size_t>(a.second + total_size + octree_header_size);
-				bin_writer.Write<size_t>(file_sizes[j].at(a.first));
+				std::vector<uint8_t> block_bytes;
+				for(const std::vector<uint8_t>& bytes : level_bytes)
+					block_bytes.insert(block_bytes.end(), bytes.begin(), bytes.end());
+				write_queue.Push(std::move(block_entries), std::move(block_bytes));
 			}
 		}
-		total_size += octree_header_size;
-
-		for(const std::string& bin : octree_bin_files) {
-			const std::string bin_path = octree_dir + "/" + bin;
-			const size_t bin_size = std::filesystem::file_size(bin_path);
-			
-			uint8_t single_byte;
-			binary_io::BinaryReader bin_reader(bin_path);
-			while(bin_reader.Read<uint8_t>(&single_byte))
-				bin_writer.Write<uint8_t>(single_byte);
-			total_size += bin_size;
-		}
-	}
 
-private:
-	///
-	/// Wrapper around std filesystem function.
-	///
-	static bool GetDirFiles(
-	  	const std::string& dir, 
-	  	std::vector<std::string>* const files
-	  	) {
-	  	files->clear();
-
-	  	for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(dir)) {
-	    	if (entry.is_regular_file())
-	        	files->push_back(entry.path().filename().string());
-	  	}
-	  	return true;
+		const bool blocks_written = write_queue.Finish();
+		return octree_writer.Finish() && blocks_written;
 	}
 
 	///
-	/// only works if the dir names dont have a dot
+	/// Rewrites the octree written by CreateOctree into output_file with the blocks in Morton order of the policy,
+	/// so neighbouring blocks are read with few seeks. The input file is removed afterwards.
 	///
-	static std::vector<std::string> GetDirFilesRecursively(const std::string& dir) {
-	    std::vector<std::string> files;
-	    GetDirFiles(dir, &files);
-
-	    std::vector<std::string> out_files;
-
-	    for(const std::string f : files) {
-			std::vector<std::string> splitted = Split(f, '.');
-			if(splitted.size() == 1) {
-				std::vector<std::string> sub_files = GetDirFilesRecursively(dir + f + "/");
-				for(std::string sf : sub_files)
-					out_files.push_back(sf);
-			} else {
-				out_files.push_back(dir + f);
-			}
-	    }
-	    return out_files;
-	}
-
-	///
-	/// Recursively searches the directory.
-	/// 
-	static bool GetDirFilesWithExtention(
-		const std::string& dir, 
-		const std::string& extention, 
-		std::vector<std::string>* const files
+	static bool SortOctree(
+			const std::string& input_file,
+			const std::string& output_file,
+			const octree_layout::LevelPolicy policy
 		) {
-		files->clear();
-		std::vector<std::string> all_files_in_dir;
-
-		const bool ret = GetDirFiles(dir, &all_files_in_dir);
-		if(!ret)
-			return false;
-
-		for(const std::string & f : all_files_in_dir) {
-			if(f.size() < extention.size())
-				continue;
-
-			const std::string last_chars_f = f.substr(f.size() - extention.size());
-			if(last_chars_f.compare(extention) == 0)
-				files->push_back(f);
+		bool ok = false;
+		{
+			const octree_reader::OctreeReader octree_reader(input_file);
+			ok = octree_reader.IsOpen() && octree_layout::RepackOctree(octree_reader, output_file, policy);
 		}
-
-		std::sort(files->begin(), files->end());
-			return true;
-	}
-
-	///
-	/// Places integers within the string into the vector. Function is unsigned.
-	///
-	static std::vector<size_t> GetIntsFromString(const std::string& str) {
-		std::vector<size_t> out;
-
-		size_t curr = 0;
-		bool valid = false;
-
-		for(const char c : str) {
-			if(c >= '0' && c <= '9') {
-				curr *= 10;
-				curr += static_cast<size_t>(c - '0');
-				valid = true;
-			} else if(valid) {
-				out.push_back(curr);
-				curr = 0;
-				valid = false;
-			}
-		}
-
-		if(valid)
-		out.push_back(curr);
-
-		return out;
-	}
-
-	///
-	/// Splits a string based on the delimiter into a vector of strings.
-	///
-	static std::vector<std::string> Split(
-		const std::string & string_to_split,
-		const char delimiter
-	) {
-		std::istringstream ss(string_to_split);
-		std::string token;
-
-		std::vector<std::string> output;
-
-		while(std::getline(ss, token, delimiter)) 
-			output.push_back(token);
-
-		// get rid of trailing null
-		if(output.back().back() == '\n')
-			output.back().pop_back();
-
-		return output;
+		std::error_code error;
+		std::filesystem::remove(input_file, error);
+		return ok;
 	}
 };
 
@@ -404,10 +542,50 @@ int main(int argc, char* argv[]) {
 	const size_t level_to_become_level_zero = 3;
 	const size_t highest_level = 9;
 
-	Converter::CreateHashedFiles(FLAGS_input_ply_file, FLAGS_cache_folder, 
-		level_to_become_level_zero, highest_level + 1);
-	Converter::FileBundling(FLAGS_cache_folder, FLAGS_output_octree_file, 
-		highest_level - level_to_become_level_zero + 1);
+	point_records::Encoding encoding;
+	if(FLAGS_encoding == "quantized") {
+		encoding = point_records::Encoding::kXyzRgbQuantized;
+	} else if(FLAGS_encoding == "float") {
+		encoding = point_records::Encoding::kXyzRgb;
+	} else if(FLAGS_encoding == "aligned") {
+		encoding = point_records::Encoding::kXyzRgba;
+	} else {
+		std::cerr << "unknown encoding " << FLAGS_encoding << std::endl;
+		return 1;
+	}
+
+	// the blocks are written in the order their chunks finish, a sorted layout is a rewrite of that file
+	const bool sort_blocks = (FLAGS_block_layout != "finish");
+	octree_layout::LevelPolicy level_policy = octree_layout::LevelPolicy::kGrouped;
+	if(sort_blocks && !octree_layout::ParseLevelPolicy(FLAGS_block_layout, &level_policy)) {
+		std::cerr << "unknown block layout " << FLAGS_block_layout << std::endl;
+		return 1;
+	}
+	const std::string blocks_file = sort_blocks ? FLAGS_output_octree_file + ".unsorted" : FLAGS_output_octree_file;
+
+	if(!FLAGS_cache_folder.empty())
+		std::cerr << "--cache_folder is ignored, the chunks are no longer cached on disk" << std::endl;
+
+	if(FLAGS_compress && encoding != point_records::Encoding::kXyzRgbQuantized) {
+		std::cerr << "compression requires the quantized encoding" << std::endl;
+		return 1;
+	}
+
+	const size_t num_cores = static_cast<size_t>(omp_get_max_threads());
+	StageOptions stage_options;
+	stage_options.ingest_threads = (FLAGS_ingest_threads > 0 ? FLAGS_ingest_threads : num_cores);
+	stage_options.voxelize_threads = (FLAGS_voxelize_threads > 0 ? FLAGS_voxelize_threads : num_cores);
+	stage_options.write_queue_bytes = FLAGS_write_queue_mb * 1024 * 1024;
+
+	if(!Converter::CreateOctree(FLAGS_input_ply_file, blocks_file,
+		level_to_become_level_zero, highest_level + 1, encoding, FLAGS_compress, stage_options)) {
+		std::cerr << "could not write " << blocks_file << std::endl;
+		return 1;
+	}
+	if(sort_blocks && !Converter::SortOctree(blocks_file, FLAGS_output_octree_file, level_policy)) {
+		std::cerr << "could not write " << FLAGS_output_octree_file << std::endl;
+		return 1;
+	}
 
     return 0;
 }
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <random>
+#include <cstring>
+
+#include <gflags/gflags.h>
+
+#include <FileIO/PointRecords.h>
+
+DEFINE_uint64(num_records, 1000000, "number of random 15 byte records to decode");
+DEFINE_uint64(repetitions, 20, "number of timed decodes of the whole buffer per variant");
+
+namespace {
+
+///
+/// The per-record loop the block decoders used before DecodeXyzRgb.
+///
+void DecodeLoop(
+	const uint8_t* const records,
+	const size_t num_records,
+	std::vector<std::array<float, 4>>* const xyz1,
+	std::vector<std::array<uint8_t, 4>>* const rgba
+	) {
+	const uint8_t* record = records;
+	for(size_t i = 0; i < num_records; ++i, record += sizeof(point_records::XyzRgb)) {
+		std::memcpy(&(*xyz1)[i][0], record, 3 * sizeof(float));
+		(*xyz1)[i][3] = 1.0f;
+		std::memcpy(&(*rgba)[i][0], record + 3 * sizeof(float), 3 * sizeof(uint8_t));
+		(*rgba)[i][3] = 255;
+	}
+}
+
+///
+/// Returns the best time of the repetitions in seconds.
+///
+template<typename Decode>
+double BestTime(const Decode& decode) {
+	double best = 0.0;
+	for(uint64_t r = 0; r < FLAGS_repetitions; ++r) {
+		const auto start = std::chrono::steady_clock::now();
+		decode();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if(r == 0 || seconds < best)
+			best = seconds;
+	}
+	return best;
+}
+
+} // namespace
+
+///
+/// Compares the throughput of the per-record decode loop with the vectorized DecodeXyzRgb kernel
+/// and checks that both produce the same output.
+///
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+	const size_t num_records = FLAGS_num_records;
+	if(num_records == 0 || FLAGS_repetitions == 0) {
+		std::cerr << "num_records and repetitions have to be positive" << std::endl;
+		return 1;
+	}
+	std::vector<uint8_t> records(num_records * sizeof(point_records::XyzRgb));
+	std::mt19937 random_engine(1);
+	std::uniform_real_distribution<float> coordinate(-1000.0f, 1000.0f);
+	for(size_t i = 0; i < num_records; ++i) {
+		point_records::XyzRgb record;
+		record.xyz = {{coordinate(random_engine), coordinate(random_engine), coordinate(random_engine)}};
+		for(uint8_t& channel : record.rgb)
+			channel = static_cast<uint8_t>(random_engine());
+		std::memcpy(&records[i * sizeof(point_records::XyzRgb)], &record, sizeof(point_records::XyzRgb));
+	}
+
+	std::vector<std::array<float, 4>> loop_xyz1(num_records);
+	std::vector<std::array<uint8_t, 4>> loop_rgba(num_records);
+	std::vector<std::array<float, 4>> kernel_xyz1(num_records);
+	std::vector<std::array<uint8_t, 4>> kernel_rgba(num_records);
+
+	const double loop_seconds = BestTime([&]() {
+		DecodeLoop(records.data(), num_records, &loop_xyz1, &loop_rgba);
+	});
+	const double kernel_seconds = BestTime([&]() {
+		point_records::DecodeXyzRgb(records.data(), num_records, &kernel_xyz1[0][0], sizeof(std::array<float, 4>), &kernel_rgba[0][0], sizeof(std::array<uint8_t, 4>));
+	});
+	const double scalar_seconds = BestTime([&]() {
+		point_records::DecodeXyzRgbScalar(records.data(), num_records, &kernel_xyz1[0][0], sizeof(std::array<float, 4>), &kernel_rgba[0][0], sizeof(std::array<uint8_t, 4>));
+	});
+	point_records::DecodeXyzRgb(records.data(), num_records, &kernel_xyz1[0][0], sizeof(std::array<float, 4>), &kernel_rgba[0][0], sizeof(std::array<uint8_t, 4>));
+
+	if(loop_xyz1 != kernel_xyz1 || loop_rgba != kernel_rgba) {
+		std::cerr << "the kernel output differs from the loop" << std::endl;
+		return 1;
+	}
+
+	const double megabytes = static_cast<double>(records.size()) / (1024.0 * 1024.0);
+	std::cout << "records: " << num_records << std::endl;
+	std::cout << "loop:   " << loop_seconds * 1000.0 << " ms, " << megabytes / loop_seconds << " MB/s" << std::endl;
+	std::cout << "scalar: " << scalar_seconds * 1000.0 << " ms, " << megabytes / scalar_seconds << " MB/s" << std::endl;
+	std::cout << "kernel: " << kernel_seconds * 1000.0 << " ms, " << megabytes / kernel_seconds << " MB/s" << std::endl;
+	std::cout << "speedup: " << loop_seconds / kernel_seconds << "x" << std::endl;
+
+    return 0;
+}
@@ -13,6 +13,9 @@
 #include <FileIO/OctreeReader.h>
 
 DEFINE_string(octree_file, "", "required");
+DEFINE_bool(mmap_octree, false, "memory map the octree file instead of reading blocks into buffers");
+DEFINE_uint64(gpu_memory_budget_mb, 1024, "gpu memory the detail levels may occupy before hidden blocks are evicted");
+DEFINE_uint64(read_coalescing_gap_kb, 64, "block reads at most this far apart in the file are merged into one read");
 
 int main(int argc, char* argv[]) {
     gflags::ParseCommandLineFlags(&argc, &argv, true);
@@ -45,9 +48,17 @@ int main(int argc, char* argv[]) {
 
     if (std::filesystem::path(octree_file).extension() != ".octree")
         return 0;
-    octree_reader::OctreeReader octree_reader(octree_file);
+    octree_reader::OctreeReader octree_reader(octree_file,
+        FLAGS_mmap_octree ? octree_reader::AccessMode::kMemoryMapped : octree_reader::AccessMode::kRead);
+    if (!octree_reader.IsOpen()) {
+        QMessageBox::critical(nullptr, "LodViewer",
+            QString::fromStdString(octree_file + " is not an octree file of a supported version or its index is corrupt"));
+        return 1;
+    }
 
-    gui::Window<double> main_window(octree_reader);
+    gui::Window<double> main_window(octree_reader,
+        static_cast<size_t>(FLAGS_gpu_memory_budget_mb) * 1024 * 1024,
+        static_cast<size_t>(FLAGS_read_coalescing_gap_kb) * 1024);
     main_window.show();
     app.exec();
 
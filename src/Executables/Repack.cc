@@ -0,0 +1,41 @@
+#include <iostream>
+
+#include <gflags/gflags.h>
+
+#include <FileIO/OctreeReader.h>
+#include <FileIO/OctreeLayout.h>
+
+DEFINE_string(input_octree_file, "", "required");
+DEFINE_string(output_octree_file, "", "required");
+DEFINE_string(block_layout, "grouped", "order of the levels of a block in the file: grouped or interleaved");
+
+///
+/// Rewrites an existing .octree file with its payloads in Morton order of the blocks.
+///
+int main(int argc, char* argv[]) {
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+	octree_layout::LevelPolicy level_policy;
+	if(!octree_layout::ParseLevelPolicy(FLAGS_block_layout, &level_policy)) {
+		std::cerr << "unknown block layout " << FLAGS_block_layout << std::endl;
+		return 1;
+	}
+	if(FLAGS_input_octree_file == FLAGS_output_octree_file) {
+		std::cerr << "the octree can not be repacked in place" << std::endl;
+		return 1;
+	}
+
+	const octree_reader::OctreeReader octree_reader(FLAGS_input_octree_file);
+	if(!octree_reader.IsOpen()) {
+		std::cerr << "could not read " << FLAGS_input_octree_file << std::endl;
+		return 1;
+	}
+
+	const bool ok = octree_layout::RepackOctree(octree_reader, FLAGS_output_octree_file, level_policy);
+	if(!ok) {
+		std::cerr << "could not write " << FLAGS_output_octree_file << std::endl;
+		return 1;
+	}
+
+    return 0;
+}
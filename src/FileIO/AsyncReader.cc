@@ -0,0 +1,486 @@
+#include "AsyncReader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define ASYNC_IO_HAS_IO_URING 1
+#else
+#define ASYNC_IO_HAS_IO_URING 0
+#endif
+
+namespace async_io {
+
+namespace {
+
+#if ASYNC_IO_HAS_IO_URING && defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+int IoUringSetup(
+	const unsigned entries,
+	io_uring_params* const params
+	) {
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(
+	const int ring_fd,
+	const unsigned to_submit,
+	const unsigned min_complete,
+	const unsigned flags
+	) {
+	return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+#else
+#undef ASYNC_IO_HAS_IO_URING
+#define ASYNC_IO_HAS_IO_URING 0
+#endif
+
+// ring indices are shared with the kernel
+unsigned LoadAcquire(const unsigned* const p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void StoreRelease(
+	unsigned* const p,
+	const unsigned value
+	) {
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+} // namespace
+
+AsyncReader::AsyncReader(
+		const std::string& file,
+		const size_t queue_depth,
+		const Backend backend
+		) : queue_depth_(std::max<size_t>(queue_depth, 1)) {
+	fd_ = open(file.c_str(), O_RDONLY);
+
+	// without a file the pool still runs, so every request completes with a failure instead of hanging
+	if(fd_ >= 0 && backend != Backend::kThreadPool && InitIoUring()) {
+		backend_ = Backend::kIoUring;
+		return;
+	}
+
+	backend_ = Backend::kThreadPool;
+	StartThreadPool();
+}
+
+AsyncReader::~AsyncReader() {
+	if(backend_ == Backend::kIoUring) {
+		// the kernel may still write into the destinations, wait for everything that is in flight
+		// requests that did not reach the kernel yet are dropped
+		pending_.clear();
+		for(const size_t slot : ready_slots_)
+			in_flight_[slot].used = false;
+		ready_slots_.clear();
+
+		std::vector<ReadCompletion> discarded;
+		while(std::any_of(in_flight_.begin(), in_flight_.end(), [](const InFlight& slot){ return slot.used; }))
+			ReapIoUring(&discarded, true);
+
+		if(sqes_ != nullptr)
+			munmap(sqes_, sqes_size_);
+		if(cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+			munmap(cq_ring_, cq_ring_size_);
+		if(sq_ring_ != nullptr)
+			munmap(sq_ring_, sq_ring_size_);
+		if(ring_fd_ >= 0)
+			close(ring_fd_);
+	} else {
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex_);
+			pool_stop_ = true;
+			pending_.clear();
+		}
+		pool_request_cv_.notify_all();
+		for(std::unique_ptr<std::thread>& thread : pool_threads_)
+			thread->join();
+	}
+
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+void AsyncReader::EnableCoalescing(
+		const size_t max_gap,
+		const size_t max_read_size
+		) {
+	coalescing_ = true;
+	coalescing_max_gap_ = max_gap;
+	coalescing_max_read_size_ = max_read_size;
+}
+
+void AsyncReader::Submit(const std::vector<ReadRequest>& requests) {
+	if(requests.empty())
+		return;
+	num_outstanding_ += requests.size();
+
+	if(!coalescing_) {
+		SubmitReads(requests);
+		return;
+	}
+
+	// every read becomes a group, the read of a group carries the group index as user data
+	sorted_requests_ = requests;
+	std::sort(sorted_requests_.begin(), sorted_requests_.end(), [](const ReadRequest& a, const ReadRequest& b) {
+		return a.offset < b.offset;
+	});
+
+	group_reads_.clear();
+	for(size_t begin = 0; begin < sorted_requests_.size();) {
+		size_t read_end = sorted_requests_[begin].offset + sorted_requests_[begin].size;
+		size_t end = begin + 1;
+		while(end < sorted_requests_.size()
+			&& sorted_requests_[end].offset <= read_end + coalescing_max_gap_
+			&& std::max(read_end, sorted_requests_[end].offset + sorted_requests_[end].size) - sorted_requests_[begin].offset <= coalescing_max_read_size_) {
+			read_end = std::max(read_end, sorted_requests_[end].offset + sorted_requests_[end].size);
+			++end;
+		}
+
+		size_t group_index = groups_.size();
+		if(free_groups_.empty()) {
+			groups_.emplace_back(new Group);
+		} else {
+			group_index = free_groups_.back();
+			free_groups_.pop_back();
+		}
+		Group& group = *groups_[group_index];
+		group.offset = sorted_requests_[begin].offset;
+		group.members.assign(sorted_requests_.begin() + static_cast<std::ptrdiff_t>(begin), sorted_requests_.begin() + static_cast<std::ptrdiff_t>(end));
+
+		// a single request is read directly into its destination
+		uint8_t* destination = group.members[0].destination;
+		if(group.members.size() > 1) {
+			group.buffer.resize(read_end - group.offset);
+			destination = group.buffer.data();
+		}
+		group_reads_.push_back({group.offset, read_end - group.offset, destination, static_cast<uint64_t>(group_index)});
+		begin = end;
+	}
+	SubmitReads(group_reads_);
+}
+
+size_t AsyncReader::Reap(
+		std::vector<ReadCompletion>* const completions,
+		const size_t min_completions
+		) {
+	const size_t num_wanted = std::min(min_completions, num_outstanding_);
+	size_t num_reaped = 0;
+
+	if(backend_ == Backend::kIoUring) {
+		bool wait = false;
+		do {
+			read_completions_.clear();
+			ReapIoUring(&read_completions_, wait);
+			num_reaped += CompleteReads(read_completions_, completions);
+			wait = true;
+		} while(num_reaped < num_wanted);
+		return num_reaped;
+	}
+
+	do {
+		read_completions_.clear();
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex_);
+			if(num_reaped < num_wanted)
+				pool_completion_cv_.wait(lock, [&](){ return !pool_completions_.empty(); });
+			read_completions_.assign(pool_completions_.begin(), pool_completions_.end());
+			pool_completions_.clear();
+		}
+		num_reaped += CompleteReads(read_completions_, completions);
+	} while(num_reaped < num_wanted);
+	return num_reaped;
+}
+
+void AsyncReader::SubmitReads(const std::vector<ReadRequest>& reads) {
+	num_reads_ += reads.size();
+
+	if(backend_ == Backend::kIoUring) {
+		pending_.insert(pending_.end(), reads.begin(), reads.end());
+		SubmitIoUring();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex_);
+		pending_.insert(pending_.end(), reads.begin(), reads.end());
+	}
+	pool_request_cv_.notify_all();
+}
+
+size_t AsyncReader::CompleteReads(
+		const std::vector<ReadCompletion>& reads,
+		std::vector<ReadCompletion>* const completions
+		) {
+	const size_t num_before = completions->size();
+	for(const ReadCompletion& read : reads) {
+		if(!coalescing_) {
+			completions->push_back(read);
+			continue;
+		}
+
+		const size_t group_index = static_cast<size_t>(read.user_data);
+		Group& group = *groups_[group_index];
+		if(group.members.size() == 1) {
+			completions->push_back({group.members[0].user_data, read.bytes_read, read.ok});
+		} else {
+			// split the merged read into the destinations of its requests
+			for(const ReadRequest& member : group.members) {
+				const size_t relative_offset = member.offset - group.offset;
+				const size_t num_bytes = read.bytes_read > relative_offset ? std::min(member.size, read.bytes_read - relative_offset) : 0;
+				std::memcpy(member.destination, group.buffer.data() + relative_offset, num_bytes);
+				completions->push_back({member.user_data, num_bytes, num_bytes == member.size});
+			}
+		}
+		group.members.clear();
+		free_groups_.push_back(group_index);
+	}
+
+	const size_t num_completed = completions->size() - num_before;
+	num_outstanding_ -= num_completed;
+	return num_completed;
+}
+
+bool AsyncReader::InitIoUring() {
+#if ASYNC_IO_HAS_IO_URING
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	ring_fd_ = IoUringSetup(static_cast<unsigned>(queue_depth_), &params);
+	// not available in the kernel, or forbidden by seccomp in containers
+	if(ring_fd_ < 0)
+		return false;
+
+	sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if(single_mmap)
+		sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+	sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+	if(sq_ring_ == MAP_FAILED) {
+		sq_ring_ = nullptr;
+		close(ring_fd_);
+		ring_fd_ = -1;
+		return false;
+	}
+
+	if(single_mmap) {
+		cq_ring_ = sq_ring_;
+	} else {
+		cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+		if(cq_ring_ == MAP_FAILED) {
+			cq_ring_ = nullptr;
+			munmap(sq_ring_, sq_ring_size_);
+			sq_ring_ = nullptr;
+			close(ring_fd_);
+			ring_fd_ = -1;
+			return false;
+		}
+	}
+
+	sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+	sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+	if(sqes_ == MAP_FAILED) {
+		sqes_ = nullptr;
+		if(cq_ring_ != sq_ring_)
+			munmap(cq_ring_, cq_ring_size_);
+		munmap(sq_ring_, sq_ring_size_);
+		sq_ring_ = cq_ring_ = nullptr;
+		close(ring_fd_);
+		ring_fd_ = -1;
+		return false;
+	}
+
+	uint8_t* const sq = static_cast<uint8_t*>(sq_ring_);
+	uint8_t* const cq = static_cast<uint8_t*>(cq_ring_);
+	sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	cqes_ = cq + params.cq_off.cqes;
+	num_sq_entries_ = params.sq_entries;
+
+	// never more requests in flight than submission entries, so resubmissions always find space
+	in_flight_.resize(std::min<size_t>(queue_depth_, num_sq_entries_));
+	iovecs_.resize(in_flight_.size());
+	for(size_t i = in_flight_.size(); i > 0; --i)
+		free_slots_.push_back(i - 1);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AsyncReader::SubmitIoUring() {
+#if ASYNC_IO_HAS_IO_URING
+	while(!pending_.empty() && !free_slots_.empty()) {
+		const size_t slot = free_slots_.back();
+		free_slots_.pop_back();
+		in_flight_[slot].request = pending_.front();
+		in_flight_[slot].bytes_read = 0;
+		in_flight_[slot].used = true;
+		pending_.pop_front();
+		ready_slots_.push_back(slot);
+	}
+
+	io_uring_sqe* const sqes = static_cast<io_uring_sqe*>(sqes_);
+	unsigned tail = *sq_tail_;
+	while(!ready_slots_.empty() && tail - LoadAcquire(sq_head_) < num_sq_entries_) {
+		const size_t slot = ready_slots_.front();
+		ready_slots_.pop_front();
+
+		const InFlight& entry = in_flight_[slot];
+		iovecs_[slot].iov_base = entry.request.destination + entry.bytes_read;
+		iovecs_[slot].iov_len = entry.request.size - entry.bytes_read;
+
+		const unsigned index = tail & *sq_mask_;
+		io_uring_sqe* const sqe = &sqes[index];
+		std::memset(sqe, 0, sizeof(io_uring_sqe));
+		// readv is available on every kernel with io_uring, plain read only from 5.6 on
+		sqe->opcode = IORING_OP_READV;
+		sqe->fd = fd_;
+		sqe->off = static_cast<uint64_t>(entry.request.offset + entry.bytes_read);
+		sqe->addr = reinterpret_cast<uint64_t>(&iovecs_[slot]);
+		sqe->len = 1;
+		sqe->user_data = static_cast<uint64_t>(slot);
+		sq_array_[index] = index;
+		++tail;
+	}
+	StoreRelease(sq_tail_, tail);
+
+	const unsigned to_submit = tail - LoadAcquire(sq_head_);
+	if(to_submit > 0)
+		IoUringEnter(ring_fd_, to_submit, 0, 0);
+#endif
+}
+
+size_t AsyncReader::ReapIoUring(
+		std::vector<ReadCompletion>* const completions,
+		const bool wait
+		) {
+#if ASYNC_IO_HAS_IO_URING
+	unsigned head = *cq_head_;
+	if(wait && head == LoadAcquire(cq_tail_)) {
+		const unsigned to_submit = *sq_tail_ - LoadAcquire(sq_head_);
+		const int ret = IoUringEnter(ring_fd_, to_submit, 1, IORING_ENTER_GETEVENTS);
+		if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			// the ring is unusable, fail everything that is outstanding so callers do not wait forever
+			size_t num_failed = 0;
+			for(size_t slot = 0; slot < in_flight_.size(); ++slot) {
+				if(!in_flight_[slot].used)
+					continue;
+				completions->push_back({in_flight_[slot].request.user_data, in_flight_[slot].bytes_read, false});
+				in_flight_[slot].used = false;
+				free_slots_.push_back(slot);
+				++num_failed;
+			}
+			for(const ReadRequest& request : pending_) {
+				completions->push_back({request.user_data, 0, false});
+				++num_failed;
+			}
+			pending_.clear();
+			ready_slots_.clear();
+			return num_failed;
+		}
+	}
+
+	const io_uring_cqe* const cqes = static_cast<const io_uring_cqe*>(cqes_);
+	size_t num_completed = 0;
+	const unsigned tail = LoadAcquire(cq_tail_);
+	for(; head != tail; ++head) {
+		const io_uring_cqe& cqe = cqes[head & *cq_mask_];
+		const size_t slot = static_cast<size_t>(cqe.user_data);
+		InFlight& entry = in_flight_[slot];
+
+		if(cqe.res == -EAGAIN || cqe.res == -EINTR) {
+			ready_slots_.push_back(slot);
+			continue;
+		}
+
+		if(cqe.res > 0) {
+			entry.bytes_read += static_cast<size_t>(cqe.res);
+			// short read in the middle of the file, continue with the remainder
+			if(entry.bytes_read < entry.request.size) {
+				ready_slots_.push_back(slot);
+				continue;
+			}
+		}
+
+		completions->push_back({
+			entry.request.user_data,
+			entry.bytes_read,
+			entry.bytes_read == entry.request.size
+		});
+		entry.used = false;
+		free_slots_.push_back(slot);
+		++num_completed;
+	}
+	StoreRelease(cq_head_, head);
+
+	// completions freed slots for pending requests and may have queued resubmissions
+	if(!pending_.empty() || !ready_slots_.empty())
+		SubmitIoUring();
+	return num_completed;
+#else
+	(void) completions;
+	(void) wait;
+	return 0;
+#endif
+}
+
+void AsyncReader::StartThreadPool() {
+	const size_t num_threads = std::min<size_t>(queue_depth_, std::max<unsigned>(std::thread::hardware_concurrency(), 1));
+	for(size_t i = 0; i < num_threads; ++i)
+		pool_threads_.emplace_back(new std::thread(&AsyncReader::ThreadPoolWorker, this));
+}
+
+void AsyncReader::ThreadPoolWorker() {
+	while(true) {
+		ReadRequest request;
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex_);
+			pool_request_cv_.wait(lock, [&](){ return pool_stop_ || !pending_.empty(); });
+			if(pool_stop_)
+				return;
+			request = pending_.front();
+			pending_.pop_front();
+		}
+
+		const ReadCompletion completion = ReadFully(request);
+		{
+			std::lock_guard<std::mutex> lock(pool_mutex_);
+			pool_completions_.push_back(completion);
+		}
+		pool_completion_cv_.notify_one();
+	}
+}
+
+ReadCompletion AsyncReader::ReadFully(const ReadRequest& request) const {
+	ReadCompletion completion;
+	completion.user_data = request.user_data;
+	while(completion.bytes_read < request.size) {
+		const ssize_t ret = pread(fd_,
+			request.destination + completion.bytes_read,
+			request.size - completion.bytes_read,
+			static_cast<off_t>(request.offset + completion.bytes_read));
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0)
+			break;
+		completion.bytes_read += static_cast<size_t>(ret);
+	}
+	completion.ok = completion.bytes_read == request.size;
+	return completion;
+}
+
+} // namespace async_io
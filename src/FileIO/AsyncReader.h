@@ -0,0 +1,223 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include <sys/uio.h>
+
+namespace async_io {
+
+///
+/// One positional read of size bytes at offset into destination.
+/// The destination has to stay valid until the completion of the request is returned.
+///
+struct ReadRequest {
+	size_t offset = 0;
+	size_t size = 0;
+	uint8_t* destination = nullptr;
+	uint64_t user_data = 0;
+};
+
+///
+/// Result of a request, identified by its user data.
+/// Less bytes than requested are only returned at the end of the file or on errors.
+///
+struct ReadCompletion {
+	uint64_t user_data = 0;
+	size_t bytes_read = 0;
+	bool ok = false;
+};
+
+///
+/// kAuto uses io_uring if the kernel allows it and the thread pool otherwise.
+///
+enum class Backend {
+	kAuto,
+	kIoUring,
+	kThreadPool
+};
+
+///
+/// Asynchronous reader on a single file.
+/// Batches of requests are queued with Submit and complete out of order into a completion queue that is drained with Reap.
+/// With io_uring, up to queue_depth reads are in flight in the kernel at once; the fallback keeps a pool of threads doing pread.
+/// Submit and Reap are meant to be called from a single thread.
+///
+class AsyncReader {
+public:
+	AsyncReader(
+		const std::string& file,
+		const size_t queue_depth = 64,
+		const Backend backend = Backend::kAuto
+		);
+	~AsyncReader();
+
+	AsyncReader(const AsyncReader&) = delete;
+	AsyncReader& operator=(const AsyncReader&) = delete;
+
+	///
+	/// Returns false if the file could not be opened.
+	///
+	bool IsOpen() const {
+		return fd_ >= 0;
+	}
+
+	///
+	/// Backend that is actually used, never kAuto.
+	///
+	Backend GetBackend() const {
+		return backend_;
+	}
+
+	///
+	/// Merges requests of a batch whose byte ranges are adjacent or at most max_gap bytes apart into one larger read.
+	/// The merged read goes into an internal buffer and is split into the destinations of its requests on completion.
+	/// Merged reads do not grow beyond max_read_size, larger single requests are read as they are.
+	///
+	void EnableCoalescing(
+		const size_t max_gap,
+		const size_t max_read_size = 4 * 1024 * 1024
+		);
+
+	///
+	/// Queues the requests. Requests beyond the queue depth wait in user space until slots become free.
+	///
+	void Submit(const std::vector<ReadRequest>& requests);
+
+	///
+	/// Appends completed requests to the output, waiting until at least min_completions are available
+	/// or nothing is outstanding anymore. Returns the number of appended completions.
+	///
+	size_t Reap(
+		std::vector<ReadCompletion>* const completions,
+		const size_t min_completions = 1
+		);
+
+	///
+	/// Number of submitted requests whose completion has not been reaped yet.
+	///
+	size_t NumOutstanding() const {
+		return num_outstanding_;
+	}
+
+	///
+	/// Number of reads issued to the kernel or the pool so far.
+	/// Lower than the number of submitted requests if requests were coalesced.
+	///
+	size_t NumReads() const {
+		return num_reads_;
+	}
+
+private:
+	///
+	/// Hands reads to the backend.
+	///
+	void SubmitReads(const std::vector<ReadRequest>& reads);
+
+	///
+	/// Turns completed reads into completions of the submitted requests.
+	/// Returns the number of appended completions.
+	///
+	size_t CompleteReads(
+		const std::vector<ReadCompletion>& reads,
+		std::vector<ReadCompletion>* const completions
+		);
+
+	///
+	/// Sets up the rings, returns false if io_uring is not available.
+	///
+	bool InitIoUring();
+
+	///
+	/// Moves pending requests into free ring slots and submits them to the kernel.
+	///
+	void SubmitIoUring();
+
+	///
+	/// Drains the completion ring. Short reads are resubmitted for their remainder.
+	///
+	size_t ReapIoUring(
+		std::vector<ReadCompletion>* const completions,
+		const bool wait
+		);
+
+	void StartThreadPool();
+
+	///
+	/// Function designed to run in the pool threads.
+	///
+	void ThreadPoolWorker();
+
+	///
+	/// Blocking read of the whole request, used by the pool threads.
+	///
+	ReadCompletion ReadFully(const ReadRequest& request) const;
+
+	// a request that occupies a ring slot, with the bytes already read by earlier short reads
+	struct InFlight {
+		ReadRequest request;
+		size_t bytes_read = 0;
+		bool used = false;
+	};
+
+	// requests that are served by one read, sorted by offset
+	struct Group {
+		size_t offset = 0;
+		std::vector<ReadRequest> members;
+		std::vector<uint8_t> buffer;
+	};
+
+	int fd_ = -1;
+	Backend backend_ = Backend::kThreadPool;
+	const size_t queue_depth_;
+	size_t num_outstanding_ = 0;
+	size_t num_reads_ = 0;
+	std::deque<ReadRequest> pending_;
+	std::vector<ReadCompletion> read_completions_;
+
+	// coalescing state, groups are only touched by the thread calling Submit and Reap
+	bool coalescing_ = false;
+	size_t coalescing_max_gap_ = 0;
+	size_t coalescing_max_read_size_ = 0;
+	std::vector<std::unique_ptr<Group>> groups_;
+	std::vector<size_t> free_groups_;
+	std::vector<ReadRequest> sorted_requests_;
+	std::vector<ReadRequest> group_reads_;
+
+	// io_uring state
+	int ring_fd_ = -1;
+	void* sq_ring_ = nullptr;
+	size_t sq_ring_size_ = 0;
+	void* cq_ring_ = nullptr;
+	size_t cq_ring_size_ = 0;
+	void* sqes_ = nullptr;
+	size_t sqes_size_ = 0;
+	unsigned* sq_head_ = nullptr;
+	unsigned* sq_tail_ = nullptr;
+	unsigned* sq_mask_ = nullptr;
+	unsigned* sq_array_ = nullptr;
+	unsigned* cq_head_ = nullptr;
+	unsigned* cq_tail_ = nullptr;
+	unsigned* cq_mask_ = nullptr;
+	void* cqes_ = nullptr;
+	unsigned num_sq_entries_ = 0;
+	std::vector<InFlight> in_flight_;
+	std::vector<iovec> iovecs_;
+	std::vector<size_t> free_slots_;
+	std::deque<size_t> ready_slots_;
+
+	// thread pool state
+	std::vector<std::unique_ptr<std::thread>> pool_threads_;
+	std::mutex pool_mutex_;
+	std::condition_variable pool_request_cv_;
+	std::condition_variable pool_completion_cv_;
+	std::deque<ReadCompletion> pool_completions_;
+	bool pool_stop_ = false;
+};
+
+} // namespace async_io
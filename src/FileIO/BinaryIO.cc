@@ -1,5 +1,11 @@
 #include "BinaryIO.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 namespace binary_io {
 
 BinaryReader::BinaryReader(const std::string& file) {
@@ -54,6 +60,150 @@ void BinaryWriter::Write(const T val) {
 	ofs_.write(reinterpret_cast<const char*>(&val), static_cast<int64_t>(sizeof(T)));
 }
 
+BufferedBinaryReader::BufferedBinaryReader(
+		const std::string& file,
+		const size_t buffer_size
+		) : buffer_(std::max<size_t>(buffer_size, 4096)) {
+	fd_ = open(file.c_str(), O_RDONLY);
+	if(fd_ >= 0)
+		posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+BufferedBinaryReader::~BufferedBinaryReader() {
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+size_t BufferedBinaryReader::FileSize() const {
+	struct stat file_stat;
+	if(fd_ < 0 || fstat(fd_, &file_stat) != 0)
+		return 0;
+	return static_cast<size_t>(file_stat.st_size);
+}
+
+bool BufferedBinaryReader::ReadAt(
+		const size_t offset,
+		const size_t n,
+		std::vector<uint8_t>* const out
+		) const {
+	out->resize(n);
+	size_t done = 0;
+	while(fd_ >= 0 && done < n) {
+		const ssize_t ret = pread(fd_, out->data() + done, n - done, static_cast<off_t>(offset + done));
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0)
+			break;
+		done += static_cast<size_t>(ret);
+	}
+	out->resize(done);
+	return done == n;
+}
+
+void BufferedBinaryReader::Seek(const size_t pos) {
+	if(fd_ >= 0)
+		lseek(fd_, static_cast<off_t>(pos), SEEK_SET);
+	buffer_begin_ = 0;
+	buffer_end_ = 0;
+}
+
+size_t BufferedBinaryReader::ReadBytes(
+		uint8_t* out,
+		size_t n
+		) {
+	size_t done = 0;
+	while(n > 0) {
+		if(buffer_begin_ == buffer_end_) {
+			if(fd_ < 0)
+				break;
+
+			// large requests go straight to the destination
+			if(n >= buffer_.size()) {
+				const ssize_t ret = read(fd_, out, n);
+				if(ret < 0 && errno == EINTR)
+					continue;
+				if(ret <= 0)
+					break;
+				out += ret;
+				n -= static_cast<size_t>(ret);
+				done += static_cast<size_t>(ret);
+				continue;
+			}
+
+			const ssize_t ret = read(fd_, buffer_.data(), buffer_.size());
+			if(ret < 0 && errno == EINTR)
+				continue;
+			if(ret <= 0)
+				break;
+			buffer_begin_ = 0;
+			buffer_end_ = static_cast<size_t>(ret);
+		}
+
+		const size_t num_copy = std::min(n, buffer_end_ - buffer_begin_);
+		std::memcpy(out, buffer_.data() + buffer_begin_, num_copy);
+		buffer_begin_ += num_copy;
+		out += num_copy;
+		n -= num_copy;
+		done += num_copy;
+	}
+	return done;
+}
+
+BufferedBinaryWriter::BufferedBinaryWriter(
+		const std::string& file,
+		const bool append,
+		const size_t buffer_size
+		) : buffer_(std::max<size_t>(buffer_size, 4096)) {
+	fd_ = open(file.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+}
+
+BufferedBinaryWriter::~BufferedBinaryWriter() {
+	Flush();
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+bool BufferedBinaryWriter::Flush() {
+	if(buffer_used_ > 0)
+		WriteAll(buffer_.data(), buffer_used_);
+	buffer_used_ = 0;
+	return Good();
+}
+
+void BufferedBinaryWriter::WriteBytes(
+		const uint8_t* in,
+		size_t n
+		) {
+	if(buffer_used_ + n > buffer_.size()) {
+		Flush();
+		// large writes go straight to the file
+		if(n >= buffer_.size()) {
+			WriteAll(in, n);
+			return;
+		}
+	}
+	std::memcpy(buffer_.data() + buffer_used_, in, n);
+	buffer_used_ += n;
+}
+
+bool BufferedBinaryWriter::WriteAll(
+		const uint8_t* in,
+		size_t n
+		) {
+	while(fd_ >= 0 && good_ && n > 0) {
+		const ssize_t ret = write(fd_, in, n);
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0) {
+			good_ = false;
+			break;
+		}
+		in += ret;
+		n -= static_cast<size_t>(ret);
+	}
+	return Good();
+}
+
 template bool BinaryReader::Read<float>(float* const);
 template bool BinaryReader::Read<double>(double* const);
 template bool BinaryReader::Read<char>(char* const);
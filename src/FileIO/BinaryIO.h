@@ -2,6 +2,10 @@
 
 #include <fstream>
 #include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <type_traits>
 
 namespace binary_io {
 
@@ -64,4 +68,156 @@ private:
 	std::ofstream ofs_;
 };
 
+///
+/// Reader on a raw file descriptor with a large user-space buffer.
+/// Arrays of POD records are copied out of the buffer in bulk instead of one scalar per call.
+///
+class BufferedBinaryReader {
+public:
+	BufferedBinaryReader(
+		const std::string& file,
+		const size_t buffer_size = 8 * 1024 * 1024
+		);
+	~BufferedBinaryReader();
+
+	BufferedBinaryReader(const BufferedBinaryReader&) = delete;
+	BufferedBinaryReader& operator=(const BufferedBinaryReader&) = delete;
+
+	///
+	/// Returns false if the file could not be opened.
+	///
+	bool IsOpen() const {
+		return fd_ >= 0;
+	}
+
+	///
+	/// Size of the file in bytes.
+	///
+	size_t FileSize() const;
+
+	///
+	/// This returns the success of the read operation. If false is returned then the file is completely read.
+	///
+	template <typename T>
+	bool Read(T* const out) {
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be read as raw bytes");
+		return ReadBytes(reinterpret_cast<uint8_t*>(out), sizeof(T)) == sizeof(T);
+	}
+
+	///
+	/// Reads up to n records into out and returns the number of complete records read.
+	/// Fewer than n records are returned only at the end of the file.
+	///
+	template <typename T>
+	size_t ReadSpan(
+		T* const out,
+		const size_t n
+		) {
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be read as raw bytes");
+		return ReadBytes(reinterpret_cast<uint8_t*>(out), n * sizeof(T)) / sizeof(T);
+	}
+
+	///
+	/// Reads n bytes at the offset with a positional read. Does not use or move the buffered position.
+	/// The output is resized to the number of bytes read, false is returned if it is less than n.
+	/// Safe to call from multiple threads with different outputs.
+	///
+	bool ReadAt(
+		const size_t offset,
+		const size_t n,
+		std::vector<uint8_t>* const out
+		) const;
+
+	///
+	/// Moves the buffered position to pos and discards the buffer.
+	///
+	void Seek(const size_t pos);
+
+private:
+	///
+	/// Copies up to n bytes, refilling the buffer as needed. Returns the number of bytes copied.
+	///
+	size_t ReadBytes(
+		uint8_t* out,
+		size_t n
+		);
+
+	int fd_ = -1;
+	std::vector<uint8_t> buffer_;
+	size_t buffer_begin_ = 0;
+	size_t buffer_end_ = 0;
+};
+
+///
+/// Writer on a raw file descriptor with a large user-space buffer.
+/// The buffer is flushed when full, on Flush and in the destructor.
+///
+class BufferedBinaryWriter {
+public:
+	BufferedBinaryWriter(
+		const std::string& file,
+		const bool append = false,
+		const size_t buffer_size = 8 * 1024 * 1024
+		);
+	~BufferedBinaryWriter();
+
+	BufferedBinaryWriter(const BufferedBinaryWriter&) = delete;
+	BufferedBinaryWriter& operator=(const BufferedBinaryWriter&) = delete;
+
+	///
+	/// Returns false if the file could not be opened or a previous write failed.
+	///
+	bool Good() const {
+		return fd_ >= 0 && good_;
+	}
+
+	///
+	/// Writes the value with the specified template type.
+	///
+	template <typename T>
+	void Write(const T& val) {
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be written as raw bytes");
+		WriteBytes(reinterpret_cast<const uint8_t*>(&val), sizeof(T));
+	}
+
+	///
+	/// Writes n records as one contiguous byte range.
+	///
+	template <typename T>
+	void WriteSpan(
+		const T* const in,
+		const size_t n
+		) {
+		static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types can be written as raw bytes");
+		WriteBytes(reinterpret_cast<const uint8_t*>(in), n * sizeof(T));
+	}
+
+	///
+	/// Writes the buffered bytes to the file.
+	///
+	bool Flush();
+
+private:
+	///
+	/// Appends to the buffer, large writes bypass it.
+	///
+	void WriteBytes(
+		const uint8_t* in,
+		size_t n
+		);
+
+	///
+	/// Writes all n bytes, retrying on partial writes.
+	///
+	bool WriteAll(
+		const uint8_t* in,
+		size_t n
+		);
+
+	int fd_ = -1;
+	bool good_ = true;
+	std::vector<uint8_t> buffer_;
+	size_t buffer_used_ = 0;
+};
+
 } // namespace binary_io
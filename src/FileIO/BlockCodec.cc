@@ -0,0 +1,689 @@
+#include "BlockCodec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#if defined(__BMI2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include <FileIO/PointRecords.h>
+
+namespace block_codec {
+
+namespace {
+
+// coder constants: frequencies sum up to 2^12, the states are renormalized by 16 bit words to stay in [2^16, 2^32),
+// so a decoding step reads at most one word
+constexpr uint32_t kProbBits = 12;
+constexpr uint32_t kProbScale = 1u << kProbBits;
+constexpr uint32_t kRansLow = 1u << 16;
+
+// interleaved coder states, symbol i is coded with state i % num_states. the states of large planes fill vector
+// registers of 32 bit lanes, the decoder steps them with gathers from the decoding table and the latency of one
+// register's gather hides behind the others. every state adds its final state to the plane, so a plane uses the most
+// states, a power of two, that leave kMinSymbolsPerState symbols to each of them
+constexpr size_t kMinNumStates = 4;
+constexpr size_t kMaxNumStates = 64;
+constexpr size_t kMinSymbolsPerState = 128;
+
+// 6 byte planes of the 48 bit Morton code differences followed by 3 planes of the colour differences.
+// colours are coded as the difference of green and the differences of red and blue relative to the one of green
+constexpr size_t kNumMortonPlanes = 6;
+constexpr size_t kNumPlanes = kNumMortonPlanes + 3;
+
+enum PlaneMode : uint8_t {
+	kPlaneRaw = 0,
+	kPlaneRans = 1,
+	kPlaneConstant = 2
+};
+
+///
+/// Spreads the lower 16 bits of v so there are two zero bits between each of them.
+///
+uint64_t SpreadBits(uint64_t v) {
+#ifdef __BMI2__
+	return _pdep_u64(v, 0x249249249249);
+#else
+	v &= 0xffff;
+	v = (v | (v << 16)) & 0x0000ff0000ff;
+	v = (v | (v << 8)) & 0x00f00f00f00f;
+	v = (v | (v << 4)) & 0x0c30c30c30c3;
+	v = (v | (v << 2)) & 0x249249249249;
+	return v;
+#endif
+}
+
+///
+/// Inverse of SpreadBits.
+///
+uint16_t CompactBits(uint64_t v) {
+#ifdef __BMI2__
+	return static_cast<uint16_t>(_pext_u64(v, 0x249249249249));
+#else
+	v &= 0x249249249249;
+	v = (v | (v >> 2)) & 0x0c30c30c30c3;
+	v = (v | (v >> 4)) & 0x00f00f00f00f;
+	v = (v | (v >> 8)) & 0x0000ff0000ff;
+	v = (v | (v >> 16)) & 0xffff;
+	return static_cast<uint16_t>(v);
+#endif
+}
+
+template <typename T>
+void Append(
+	const T& value,
+	std::vector<uint8_t>* const out
+	) {
+	const size_t first = out->size();
+	out->resize(first + sizeof(T));
+	std::memcpy(out->data() + first, &value, sizeof(T));
+}
+
+///
+/// Reads a value and advances the cursor, returns false if the input is exhausted.
+///
+template <typename T>
+bool Consume(
+	const uint8_t** const cursor,
+	const uint8_t* const end,
+	T* const value
+	) {
+	if(static_cast<size_t>(end - *cursor) < sizeof(T))
+		return false;
+	std::memcpy(value, *cursor, sizeof(T));
+	*cursor += sizeof(T);
+	return true;
+}
+
+///
+/// Scales the symbol counts to frequencies that sum up to kProbScale, every occurring symbol keeps at least 1.
+///
+void NormalizeFrequencies(
+	const std::array<uint32_t, 256>& counts,
+	const size_t total,
+	std::array<uint32_t, 256>* const freqs
+	) {
+	uint32_t sum = 0;
+	for(size_t s = 0; s < 256; ++s) {
+		(*freqs)[s] = counts[s] == 0 ? 0 : std::max(1u, static_cast<uint32_t>(static_cast<uint64_t>(counts[s]) * kProbScale / total));
+		sum += (*freqs)[s];
+	}
+
+	// rounding leaves a small difference, it is taken from or given to the most frequent symbols
+	while(sum != kProbScale) {
+		const size_t largest = static_cast<size_t>(std::max_element(freqs->begin(), freqs->end()) - freqs->begin());
+		if(sum < kProbScale) {
+			(*freqs)[largest] += kProbScale - sum;
+			sum = kProbScale;
+		} else {
+			const uint32_t decrease = std::min(sum - kProbScale, (*freqs)[largest] - 1);
+			if(decrease == 0)
+				break;
+			(*freqs)[largest] -= decrease;
+			sum -= decrease;
+		}
+	}
+}
+
+///
+/// Appends the plane with the rANS coder, or raw if that does not save at least a sixteenth.
+/// Interleaved states let the decoder overlap the dependency chains of neighbouring symbols.
+///
+void EncodePlane(
+	const std::vector<uint8_t>& plane,
+	std::vector<uint8_t>* const out
+	) {
+	std::array<uint32_t, 256> counts;
+	counts.fill(0);
+	for(const uint8_t symbol : plane)
+		++counts[symbol];
+
+	// high bytes of the code differences are mostly all zero
+	if(counts[plane.front()] == plane.size()) {
+		out->push_back(kPlaneConstant);
+		out->push_back(plane.front());
+		return;
+	}
+
+	std::array<uint32_t, 256> freqs;
+	NormalizeFrequencies(counts, plane.size(), &freqs);
+	std::array<uint32_t, 256> starts;
+	uint32_t start = 0;
+	for(size_t s = 0; s < 256; ++s) {
+		starts[s] = start;
+		start += freqs[s];
+	}
+
+	// the states share one word stream. the coder works backwards and the words are reversed at the end, so the decoder
+	// reads them forwards in the order of the symbols, a round of one symbol per state reads at most one word per state
+	size_t num_states = kMinNumStates;
+	while(num_states < kMaxNumStates && plane.size() >= 2 * num_states * kMinSymbolsPerState)
+		num_states *= 2;
+	std::vector<uint16_t> reversed;
+	std::vector<uint32_t> states(num_states, kRansLow);
+	for(size_t i = plane.size(); i-- > 0; ) {
+		uint32_t& x = states[i % num_states];
+		const uint32_t freq = freqs[plane[i]];
+		const uint64_t x_max = static_cast<uint64_t>((kRansLow >> kProbBits) << 16) * freq;
+		if(x >= x_max) {
+			reversed.push_back(static_cast<uint16_t>(x & 0xffff));
+			x >>= 16;
+		}
+		x = ((x / freq) << kProbBits) + (x % freq) + starts[plane[i]];
+	}
+	const size_t payload_size = sizeof(uint8_t) + sizeof(uint32_t) + num_states * sizeof(uint32_t) + reversed.size() * sizeof(uint16_t);
+
+	uint16_t num_symbols = 0;
+	for(size_t s = 0; s < 256; ++s)
+		num_symbols = static_cast<uint16_t>(num_symbols + (freqs[s] > 0 ? 1 : 0));
+	const size_t table_size = sizeof(uint16_t) + num_symbols * (sizeof(uint8_t) + sizeof(uint16_t));
+
+	// planes of almost uniform bytes are not worth the decoding time
+	if(table_size + payload_size >= plane.size() - plane.size() / 16) {
+		out->push_back(kPlaneRaw);
+		out->insert(out->end(), plane.begin(), plane.end());
+		return;
+	}
+
+	out->push_back(kPlaneRans);
+	Append(num_symbols, out);
+	for(size_t s = 0; s < 256; ++s) {
+		if(freqs[s] == 0)
+			continue;
+		out->push_back(static_cast<uint8_t>(s));
+		Append(static_cast<uint16_t>(freqs[s]), out);
+	}
+	out->push_back(static_cast<uint8_t>(num_states));
+	Append(static_cast<uint32_t>(reversed.size() * sizeof(uint16_t)), out);
+	for(const uint32_t x : states)
+		Append(x, out);
+	for(auto word = reversed.rbegin(); word != reversed.rend(); ++word)
+		Append(*word, out);
+}
+
+///
+/// Decoding table entry of a slot: the frequency of its symbol in the low 12 bits, the offset of the slot in the range
+/// of the symbol in the next 12 bits and the symbol in the high byte, so a decoding step does one lookup.
+///
+inline uint32_t DecodeStep(
+	const uint32_t* const table,
+	uint32_t* const x
+	) {
+	const uint32_t entry = table[*x & (kProbScale - 1)];
+	*x = (entry & 0xfff) * (*x >> kProbBits) + ((entry >> 12) & 0xfff);
+	return entry >> 24;
+}
+
+#if defined(__AVX2__)
+///
+/// Per mask of 8 lanes the index of the word every lane takes when the lanes of the set bits take the next words
+/// in lane order.
+///
+constexpr std::array<std::array<uint8_t, 8>, 256> MakeExpandLanes() {
+	std::array<std::array<uint8_t, 8>, 256> lanes{};
+	for(size_t mask = 0; mask < 256; ++mask) {
+		uint8_t next = 0;
+		for(size_t lane = 0; lane < 8; ++lane) {
+			lanes[mask][lane] = next;
+			next = static_cast<uint8_t>(next + ((mask >> lane) & 1));
+		}
+	}
+	return lanes;
+}
+
+constexpr std::array<std::array<uint8_t, 8>, 256> kExpandLanes = MakeExpandLanes();
+#endif
+
+///
+/// Decodes rounds of num_states symbols, one per state. Returns false if the word stream ends early.
+///
+template <size_t kNumStatesT>
+bool DecodeRounds(
+	const uint32_t* const table,
+	const size_t rounds,
+	std::array<uint32_t, kNumStatesT>* const states,
+	const uint8_t** const words,
+	const uint8_t* const words_end,
+	uint8_t* out
+	) {
+	size_t r = 0;
+	const uint8_t* in = *words;
+#if defined(__AVX512F__) && defined(__AVX512VL__) && defined(__AVX512VBMI2__)
+	if(kNumStatesT % 16 == 0) {
+		constexpr size_t kNumRegisters = kNumStatesT / 16;
+		// the masked forms of the intrinsics, the unmasked ones start from undefined registers
+		const __mmask16 all = 0xffff;
+		const __m512i zero = _mm512_setzero_si512();
+		const __m512i low_bits = _mm512_set1_epi32(0xfff);
+		const __m512i rans_low = _mm512_set1_epi32(static_cast<int>(kRansLow));
+		__m512i x[kNumRegisters];
+		for(size_t h = 0; h < kNumRegisters; ++h)
+			x[h] = _mm512_loadu_si512(states->data() + 16 * h);
+		for(; r < rounds; ++r, out += kNumStatesT) {
+			// all gathers are issued before any register is renormalized
+			__m512i entry[kNumRegisters];
+			for(size_t h = 0; h < kNumRegisters; ++h)
+				entry[h] = _mm512_mask_i32gather_epi32(zero, all, _mm512_and_si512(x[h], low_bits), table, 4);
+			for(size_t h = 0; h < kNumRegisters; ++h) {
+				_mm512_mask_cvtepi32_storeu_epi8(out + 16 * h, all, _mm512_maskz_srli_epi32(all, entry[h], 24));
+				x[h] = _mm512_add_epi32(
+					_mm512_mullo_epi32(_mm512_and_si512(entry[h], low_bits), _mm512_maskz_srli_epi32(all, x[h], kProbBits)),
+					_mm512_and_si512(_mm512_maskz_srli_epi32(all, entry[h], 12), low_bits));
+				// the states that renormalize take the next words of the stream in lane order,
+				// the expanding load reads only as many words as there are states to renormalize
+				const __mmask16 renormalize = _mm512_cmplt_epu32_mask(x[h], rans_low);
+				const size_t num_words = static_cast<size_t>(__builtin_popcount(renormalize));
+				if(static_cast<size_t>(words_end - in) < num_words * sizeof(uint16_t))
+					return false;
+				const __m512i next = _mm512_maskz_cvtepu16_epi32(renormalize, _mm256_maskz_expandloadu_epi16(renormalize, in));
+				x[h] = _mm512_mask_or_epi32(x[h], renormalize, _mm512_maskz_slli_epi32(all, x[h], 16), next);
+				in += num_words * sizeof(uint16_t);
+			}
+		}
+		for(size_t h = 0; h < kNumRegisters; ++h)
+			_mm512_storeu_si512(states->data() + 16 * h, x[h]);
+	}
+#elif defined(__AVX2__)
+	if(kNumStatesT % 8 == 0) {
+		constexpr size_t kNumRegisters = kNumStatesT / 8;
+		const __m256i low_bits = _mm256_set1_epi32(0xfff);
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i x[kNumRegisters];
+		for(size_t h = 0; h < kNumRegisters; ++h)
+			x[h] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(states->data() + 8 * h));
+		for(; r < rounds; ++r, out += kNumStatesT) {
+			__m256i entry[kNumRegisters];
+			for(size_t h = 0; h < kNumRegisters; ++h)
+				entry[h] = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), _mm256_and_si256(x[h], low_bits), 4);
+			for(size_t h = 0; h < kNumRegisters; ++h) {
+				// the symbols are in the high byte of every lane, packed into the low 4 bytes of both 128 bit halves
+				const __m256i symbols16 = _mm256_packus_epi32(_mm256_srli_epi32(entry[h], 24), zero);
+				const __m256i symbols = _mm256_packus_epi16(symbols16, zero);
+				const uint32_t low_symbols = static_cast<uint32_t>(_mm256_cvtsi256_si32(symbols));
+				const uint32_t high_symbols = static_cast<uint32_t>(_mm256_extract_epi32(symbols, 4));
+				std::memcpy(out + 8 * h, &low_symbols, sizeof(uint32_t));
+				std::memcpy(out + 8 * h + 4, &high_symbols, sizeof(uint32_t));
+				x[h] = _mm256_add_epi32(
+					_mm256_mullo_epi32(_mm256_and_si256(entry[h], low_bits), _mm256_srli_epi32(x[h], kProbBits)),
+					_mm256_and_si256(_mm256_srli_epi32(entry[h], 12), low_bits));
+				// the states are unsigned, below 2^16 means the high half word is zero. the words are moved
+				// to the lanes of the states that renormalize by the permutation of the renormalization mask
+				const __m256i renormalize = _mm256_cmpeq_epi32(_mm256_srli_epi32(x[h], 16), zero);
+				const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(renormalize));
+				const size_t num_words = static_cast<size_t>(__builtin_popcount(static_cast<unsigned>(mask)));
+				const size_t available = static_cast<size_t>(words_end - in);
+				if(available < num_words * sizeof(uint16_t))
+					return false;
+				// a register loads the next 8 words, at the end of the stream they are copied first
+				__m128i packed_words;
+				if(available >= sizeof(packed_words)) {
+					packed_words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+				} else {
+					packed_words = _mm_setzero_si128();
+					std::memcpy(&packed_words, in, available);
+				}
+				const __m256i words = _mm256_cvtepu16_epi32(packed_words);
+				const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(kExpandLanes[static_cast<size_t>(mask)].data())));
+				const __m256i next = _mm256_permutevar8x32_epi32(words, lanes);
+				x[h] = _mm256_blendv_epi8(x[h], _mm256_or_si256(_mm256_slli_epi32(x[h], 16), next), renormalize);
+				in += num_words * sizeof(uint16_t);
+			}
+		}
+		for(size_t h = 0; h < kNumRegisters; ++h)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(states->data() + 8 * h), x[h]);
+	}
+#endif
+	// the renormalization is done without branches, which are unpredictable for planes of high entropy. a group of 4
+	// states loads the next 4 words at once and every state shifts out its word, so no load waits for another state.
+	// near the end of the stream the missing words read as zero and a state that needs one fails the plane
+	static_assert(kNumStatesT % 4 == 0, "the states are renormalized in groups of 4");
+	// the states are kept in a local copy, the stores of the symbols could alias them
+	std::array<uint32_t, kNumStatesT> x = *states;
+	std::array<uint8_t, kNumStatesT> symbols;
+	bool exhausted = false;
+	for(; r < rounds; ++r, out += kNumStatesT) {
+		for(size_t k = 0; k < kNumStatesT; ++k)
+			symbols[k] = static_cast<uint8_t>(DecodeStep(table, &x[k]));
+		std::memcpy(out, symbols.data(), kNumStatesT);
+		for(size_t k = 0; k < kNumStatesT; k += 4) {
+			const size_t available = std::min(static_cast<size_t>(words_end - in) / sizeof(uint16_t), size_t(4));
+			uint64_t group_words = 0;
+			if(available == 4)
+				std::memcpy(&group_words, in, sizeof(group_words));
+			else
+				std::memcpy(&group_words, in, available * sizeof(uint16_t));
+			size_t used = 0;
+			for(size_t j = k; j < k + 4; ++j) {
+				const uint32_t renormalize = x[j] < kRansLow ? 1 : 0;
+				const uint32_t word = static_cast<uint32_t>(group_words >> (16 * used)) & 0xffff;
+				x[j] = (x[j] << (16 * renormalize)) | (word & (0u - renormalize));
+				used += renormalize;
+			}
+			exhausted |= used > available;
+			in += std::min(used, available) * sizeof(uint16_t);
+		}
+	}
+	*states = x;
+	*words = in;
+	return !exhausted;
+}
+
+///
+/// Reads the states and the word stream and decodes the n symbols of the given number of states.
+/// Returns false if the stream is exhausted early.
+///
+template <size_t kNumStatesT>
+bool DecodeStates(
+	const uint32_t* const table,
+	const uint8_t** const cursor,
+	const uint8_t* const end,
+	const size_t n,
+	uint8_t* const out
+	) {
+	uint32_t stream_size = 0;
+	std::array<uint32_t, kNumStatesT> states;
+	if(!Consume(cursor, end, &stream_size))
+		return false;
+	for(uint32_t& x : states)
+		if(!Consume(cursor, end, &x))
+			return false;
+	if(static_cast<size_t>(end - *cursor) < stream_size || stream_size % sizeof(uint16_t) != 0)
+		return false;
+	const uint8_t* words = *cursor;
+	const uint8_t* const words_end = *cursor + stream_size;
+	*cursor = words_end;
+
+	// the symbols after the last full round belong to the first states
+	const size_t rounds = n / kNumStatesT;
+	if(!DecodeRounds<kNumStatesT>(table, rounds, &states, &words, words_end, out))
+		return false;
+	for(size_t i = rounds * kNumStatesT; i < n; ++i) {
+		uint32_t& x = states[i % kNumStatesT];
+		out[i] = static_cast<uint8_t>(DecodeStep(table, &x));
+		if(x < kRansLow) {
+			if(words == words_end)
+				return false;
+			uint16_t word;
+			std::memcpy(&word, words, sizeof(uint16_t));
+			x = (x << 16) | word;
+			words += sizeof(uint16_t);
+		}
+	}
+	return true;
+}
+
+///
+/// Decodes a plane of n symbols into out. Returns false on corrupt input.
+///
+bool DecodePlane(
+	const uint8_t** const cursor,
+	const uint8_t* const end,
+	const size_t n,
+	uint8_t* const out
+	) {
+	uint8_t mode = 0;
+	if(!Consume(cursor, end, &mode))
+		return false;
+
+	if(mode == kPlaneRaw) {
+		if(static_cast<size_t>(end - *cursor) < n)
+			return false;
+		std::memcpy(out, *cursor, n);
+		*cursor += n;
+		return true;
+	}
+	if(mode == kPlaneConstant) {
+		uint8_t symbol = 0;
+		if(!Consume(cursor, end, &symbol))
+			return false;
+		std::memset(out, symbol, n);
+		return true;
+	}
+	if(mode != kPlaneRans)
+		return false;
+
+	uint16_t num_symbols = 0;
+	if(!Consume(cursor, end, &num_symbols) || num_symbols < 2 || num_symbols > 256)
+		return false;
+
+	// with at least two symbols every frequency is below kProbScale and fits the 12 bits of the table entry
+	alignas(64) std::array<uint32_t, kProbScale> table;
+	uint32_t start = 0;
+	for(size_t k = 0; k < num_symbols; ++k) {
+		uint8_t symbol = 0;
+		uint16_t freq = 0;
+		if(!Consume(cursor, end, &symbol) || !Consume(cursor, end, &freq))
+			return false;
+		if(freq == 0 || start + freq >= kProbScale + (k + 1 == num_symbols ? 1 : 0))
+			return false;
+		uint32_t* const slots = table.data() + start;
+		uint32_t entry = freq | (static_cast<uint32_t>(symbol) << 24);
+		for(uint32_t slot = 0; slot < freq; ++slot, entry += 1u << 12)
+			slots[slot] = entry;
+		start += freq;
+	}
+	if(start != kProbScale)
+		return false;
+
+	uint8_t num_states = 0;
+	if(!Consume(cursor, end, &num_states))
+		return false;
+	switch(num_states) {
+	case 4: return DecodeStates<4>(table.data(), cursor, end, n, out);
+	case 8: return DecodeStates<8>(table.data(), cursor, end, n, out);
+	case 16: return DecodeStates<16>(table.data(), cursor, end, n, out);
+	case 32: return DecodeStates<32>(table.data(), cursor, end, n, out);
+	case kMaxNumStates: return DecodeStates<kMaxNumStates>(table.data(), cursor, end, n, out);
+	}
+	return false;
+}
+
+///
+/// Sums up the deltas of the n points of the planes and writes their records to out.
+///
+void ReconstructRecords(
+	const uint8_t* const planes,
+	const size_t n,
+	uint8_t* out
+	) {
+	size_t i = 0;
+	uint64_t code = 0;
+	std::array<uint8_t, 3> rgb = {{0, 0, 0}};
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VBMI__)
+	// 8 points at a time: the 6 Morton planes are transposed to the 8 code deltas and summed up in 64 bit lanes,
+	// the colour planes are summed up in the bytes of one lane per channel
+	// the masked forms of the intrinsics, the unmasked ones start from undefined registers
+	const __mmask8 all_lanes = 0xff;
+	const __mmask64 all_bytes = ~0ull;
+	const __m512i zero = _mm512_setzero_si512();
+	std::array<uint8_t, 64> transpose_indices;
+	std::array<uint8_t, 64> colour_indices;
+	std::array<uint8_t, 64> first_record_indices;
+	std::array<uint8_t, 64> last_record_indices;
+	for(size_t j = 0; j < 8; ++j)
+		for(size_t b = 0; b < 8; ++b) {
+			transpose_indices[8 * j + b] = static_cast<uint8_t>(8 * b + j);
+			colour_indices[8 * j + b] = static_cast<uint8_t>(8 * j + 7);
+		}
+	// record byte t of point j is byte t of code lane j for t < 6 and byte j of colour lane t - 6 otherwise,
+	// the colour lanes are the second table of the two table permutation
+	for(size_t byte = 0; byte < 72; ++byte) {
+		const size_t j = byte / 9;
+		const size_t t = byte % 9;
+		const uint8_t index = static_cast<uint8_t>(t < 6 ? 8 * j + t : 64 + 8 * (t - 6) + j);
+		(byte < 64 ? first_record_indices[byte] : last_record_indices[byte - 64]) = index;
+	}
+	for(size_t byte = 8; byte < 64; ++byte)
+		last_record_indices[byte] = 0;
+	const __m512i transpose = _mm512_loadu_si512(transpose_indices.data());
+	const __m512i last_colour = _mm512_loadu_si512(colour_indices.data());
+	const __m512i first_record = _mm512_loadu_si512(first_record_indices.data());
+	const __m512i last_record = _mm512_loadu_si512(last_record_indices.data());
+	const __m512i last_code = _mm512_set1_epi64(7);
+	const __m512i spread = _mm512_set1_epi64(0x249249249249);
+	const __m512i compact_masks[4] = {
+		_mm512_set1_epi64(0x0c30c30c30c3),
+		_mm512_set1_epi64(0x00f00f00f00f),
+		_mm512_set1_epi64(0x0000ff0000ff),
+		_mm512_set1_epi64(0xffff)
+	};
+	const auto compact = [&](__m512i v) {
+		v = _mm512_and_si512(v, spread);
+		v = _mm512_and_si512(_mm512_or_si512(v, _mm512_maskz_srli_epi64(all_lanes, v, 2)), compact_masks[0]);
+		v = _mm512_and_si512(_mm512_or_si512(v, _mm512_maskz_srli_epi64(all_lanes, v, 4)), compact_masks[1]);
+		v = _mm512_and_si512(_mm512_or_si512(v, _mm512_maskz_srli_epi64(all_lanes, v, 8)), compact_masks[2]);
+		return _mm512_and_si512(_mm512_or_si512(v, _mm512_maskz_srli_epi64(all_lanes, v, 16)), compact_masks[3]);
+	};
+	__m512i codes_before = zero;
+	__m512i rgb_before = zero;
+	for(; i + 8 <= n; i += 8, out += 8 * sizeof(point_records::XyzRgbQuantized)) {
+		const auto load = [planes, n, i](const size_t k) {
+			uint64_t lane;
+			std::memcpy(&lane, planes + k * n + i, sizeof(uint64_t));
+			return static_cast<long long>(lane);
+		};
+		const __m512i morton_planes = _mm512_set_epi64(0, 0, load(5), load(4), load(3), load(2), load(1), load(0));
+
+		// byte k of delta j is byte j of plane k, the 2 high bytes are zero
+		__m512i codes = _mm512_maskz_permutexvar_epi8(0x3f3f3f3f3f3f3f3f, transpose, morton_planes);
+		codes = _mm512_add_epi64(codes, _mm512_maskz_alignr_epi64(all_lanes, codes, zero, 7));
+		codes = _mm512_add_epi64(codes, _mm512_maskz_alignr_epi64(all_lanes, codes, zero, 6));
+		codes = _mm512_add_epi64(codes, _mm512_maskz_alignr_epi64(all_lanes, codes, zero, 4));
+		codes = _mm512_add_epi64(codes, codes_before);
+		codes_before = _mm512_maskz_permutexvar_epi64(all_lanes, last_code, codes);
+		const __m512i xyz = _mm512_or_si512(compact(codes),
+			_mm512_or_si512(_mm512_maskz_slli_epi64(all_lanes, compact(_mm512_maskz_srli_epi64(all_lanes, codes, 1)), 16), _mm512_maskz_slli_epi64(all_lanes, compact(_mm512_maskz_srli_epi64(all_lanes, codes, 2)), 32)));
+
+		// the lanes of the red, green and blue planes, red and blue are relative to green
+		const __m512i colour_planes = _mm512_set_epi64(0, 0, 0, 0, 0, load(8), load(7), load(6));
+		const __m512i green = _mm512_maskz_permutexvar_epi64(all_lanes, _mm512_set1_epi64(1), colour_planes);
+		__m512i colours = _mm512_mask_add_epi8(colour_planes, 0xff00ff, colour_planes, green);
+		colours = _mm512_add_epi8(colours, _mm512_maskz_slli_epi64(all_lanes, colours, 8));
+		colours = _mm512_add_epi8(colours, _mm512_maskz_slli_epi64(all_lanes, colours, 16));
+		colours = _mm512_add_epi8(colours, _mm512_maskz_slli_epi64(all_lanes, colours, 32));
+		colours = _mm512_add_epi8(colours, rgb_before);
+		rgb_before = _mm512_maskz_permutexvar_epi8(all_bytes, last_colour, colours);
+
+		_mm512_storeu_si512(out, _mm512_maskz_permutex2var_epi8(all_bytes, xyz, first_record, colours));
+		_mm512_mask_storeu_epi8(out + 64, 0xff, _mm512_maskz_permutex2var_epi8(all_bytes, xyz, last_record, colours));
+	}
+	if(i > 0) {
+		std::array<uint64_t, 8> last_codes;
+		std::array<uint8_t, 64> last_colours;
+		_mm512_storeu_si512(last_codes.data(), codes_before);
+		_mm512_storeu_si512(last_colours.data(), rgb_before);
+		code = last_codes[0];
+		rgb = {{last_colours[0], last_colours[8], last_colours[16]}};
+	}
+#endif
+	for(; i < n; ++i, out += sizeof(point_records::XyzRgbQuantized)) {
+		uint64_t delta = 0;
+		for(size_t k = 0; k < kNumMortonPlanes; ++k)
+			delta |= static_cast<uint64_t>(planes[k * n + i]) << (8 * k);
+		code += delta;
+		const uint8_t delta_g = planes[(kNumMortonPlanes + 1) * n + i];
+		rgb[0] = static_cast<uint8_t>(rgb[0] + planes[kNumMortonPlanes * n + i] + delta_g);
+		rgb[1] = static_cast<uint8_t>(rgb[1] + delta_g);
+		rgb[2] = static_cast<uint8_t>(rgb[2] + planes[(kNumMortonPlanes + 2) * n + i] + delta_g);
+
+		const point_records::XyzRgbQuantized record{{{CompactBits(code), CompactBits(code >> 1), CompactBits(code >> 2)}}, rgb};
+		std::memcpy(out, &record, sizeof(record));
+	}
+}
+
+} // namespace
+
+bool Compress(
+		const uint8_t* const data,
+		const size_t size,
+		std::vector<uint8_t>* const compressed
+		) {
+	const size_t record_size = sizeof(point_records::XyzRgbQuantized);
+	if(size % record_size != 0 || size / record_size > UINT32_MAX)
+		return false;
+	const size_t num_points = size / record_size;
+
+	// the fields of the packed records are not aligned, they are copied out instead of referenced
+	const auto load_xyz = [data, record_size](const size_t i) {
+		std::array<uint16_t, 3> xyz;
+		std::memcpy(xyz.data(), data + i * record_size + offsetof(point_records::XyzRgbQuantized, xyz), sizeof(xyz));
+		return xyz;
+	};
+	const auto load_rgb = [data, record_size](const size_t i) {
+		std::array<uint8_t, 3> rgb;
+		std::memcpy(rgb.data(), data + i * record_size + offsetof(point_records::XyzRgbQuantized, rgb), sizeof(rgb));
+		return rgb;
+	};
+
+	// ties are broken by the original position so the output does not depend on the sort implementation
+	std::vector<std::pair<uint64_t, uint32_t>> codes(num_points);
+	for(size_t i = 0; i < num_points; ++i) {
+		const std::array<uint16_t, 3> xyz = load_xyz(i);
+		codes[i] = {SpreadBits(xyz[0]) | (SpreadBits(xyz[1]) << 1) | (SpreadBits(xyz[2]) << 2), static_cast<uint32_t>(i)};
+	}
+	std::sort(codes.begin(), codes.end());
+
+	std::array<std::vector<uint8_t>, kNumPlanes> planes;
+	for(std::vector<uint8_t>& plane : planes)
+		plane.resize(num_points);
+	uint64_t previous_code = 0;
+	std::array<uint8_t, 3> previous_rgb = {{0, 0, 0}};
+	for(size_t i = 0; i < num_points; ++i) {
+		const uint64_t delta = codes[i].first - previous_code;
+		for(size_t k = 0; k < kNumMortonPlanes; ++k)
+			planes[k][i] = static_cast<uint8_t>(delta >> (8 * k));
+		const std::array<uint8_t, 3> rgb = load_rgb(codes[i].second);
+		const uint8_t delta_g = static_cast<uint8_t>(rgb[1] - previous_rgb[1]);
+		planes[kNumMortonPlanes][i] = static_cast<uint8_t>(rgb[0] - previous_rgb[0] - delta_g);
+		planes[kNumMortonPlanes + 1][i] = delta_g;
+		planes[kNumMortonPlanes + 2][i] = static_cast<uint8_t>(rgb[2] - previous_rgb[2] - delta_g);
+		previous_code = codes[i].first;
+		previous_rgb = rgb;
+	}
+
+	compressed->clear();
+	Append(static_cast<uint32_t>(num_points), compressed);
+	if(num_points == 0)
+		return true;
+	for(const std::vector<uint8_t>& plane : planes)
+		EncodePlane(plane, compressed);
+	return true;
+}
+
+bool Decompress(
+		const uint8_t* const data,
+		const size_t size,
+		const size_t decoded_size,
+		std::vector<uint8_t>* const decompressed
+		) {
+	const uint8_t* cursor = data;
+	const uint8_t* const end = data + size;
+	uint32_t num_points = 0;
+	if(!Consume(&cursor, end, &num_points))
+		return false;
+
+	// the count is checked before it sizes any allocation: it has to match the index,
+	// and every plane takes at least its mode and one byte
+	if(static_cast<size_t>(num_points) * sizeof(point_records::XyzRgbQuantized) != decoded_size)
+		return false;
+	if(num_points == 0) {
+		decompressed->clear();
+		return true;
+	}
+	if(static_cast<size_t>(end - cursor) < kNumPlanes * 2 * sizeof(uint8_t))
+		return false;
+
+	std::vector<uint8_t> planes(kNumPlanes * num_points);
+	for(size_t k = 0; k < kNumPlanes; ++k)
+		if(!DecodePlane(&cursor, end, num_points, planes.data() + k * num_points))
+			return false;
+
+	decompressed->resize(num_points * sizeof(point_records::XyzRgbQuantized));
+	ReconstructRecords(planes.data(), num_points, decompressed->data());
+	return true;
+}
+
+} // namespace block_codec
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace block_codec {
+
+///
+/// Compression of a block payload, stored per block in the index of the file.
+/// kMortonDeltaRans applies to point_records::XyzRgbQuantized payloads only.
+///
+enum class Codec : uint64_t {
+	kNone = 0,
+	kMortonDeltaRans = 1
+};
+
+///
+/// Losslessly compresses a payload of quantized records.
+/// The records are sorted by the Morton code of their coordinates, the code differences and the colour differences
+/// of neighbouring records are split into byte planes and every plane is coded with an order-0 rANS coder.
+/// The point set is preserved, the order of the records is not: Decompress returns them in Morton order,
+/// so payloads whose record order carries meaning must not be compressed.
+/// Returns false if size is not a multiple of the record size.
+///
+bool Compress(
+	const uint8_t* const data,
+	const size_t size,
+	std::vector<uint8_t>* const compressed
+	);
+
+///
+/// Decompresses into quantized records, replacing the content of decompressed.
+/// decoded_size is the size of the records as stored in the index, nothing is allocated if the payload disagrees.
+/// Returns false on corrupt input.
+///
+bool Decompress(
+	const uint8_t* const data,
+	const size_t size,
+	const size_t decoded_size,
+	std::vector<uint8_t>* const decompressed
+	);
+
+} // namespace block_codec
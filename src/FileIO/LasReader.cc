@@ -0,0 +1,198 @@
+#include "LasReader.h"
+
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// point records are decoded in ranges of this many
+constexpr size_t kPointsPerRange = 65536;
+
+// number of records checked for colour values above 255 to tell 16 bit from 8 bit colours
+constexpr size_t kColorProbePoints = 65536;
+
+// positions in the public header block
+constexpr size_t kVersionMinorOffset = 25;
+constexpr size_t kHeaderSizeOffset = 94;
+constexpr size_t kPointDataOffsetOffset = 96;
+constexpr size_t kPointFormatOffset = 104;
+constexpr size_t kRecordLengthOffset = 105;
+constexpr size_t kLegacyNumPointsOffset = 107;
+constexpr size_t kScaleOffset = 131;
+constexpr size_t kOffsetOffset = 155;
+constexpr size_t kNumPointsOffset = 247;
+constexpr size_t kMinHeaderSize = 227;
+constexpr size_t kHeaderSize14 = 375;
+
+// x, y, z, intensity are at the same position in all formats
+constexpr size_t kIntensityOffset = 12;
+
+template <typename S>
+S Load(const uint8_t* const p) {
+	S value;
+	std::memcpy(&value, p, sizeof(S));
+	return value;
+}
+
+///
+/// Minimum record length and position of RGB of the point data record formats, 0 for formats without colours.
+///
+bool PointFormatLayout(
+		const uint8_t format,
+		size_t* const record_length,
+		size_t* const rgb_offset
+		) {
+	static const std::array<std::pair<size_t, size_t>, 11> layouts = {{
+		{20, 0},
+		{28, 0},
+		{26, 20},
+		{34, 28},
+		{57, 0},
+		{63, 28},
+		{30, 0},
+		{36, 30},
+		{38, 30},
+		{59, 0},
+		{67, 30}
+	}};
+	if(format >= layouts.size())
+		return false;
+	*record_length = layouts[format].first;
+	*rgb_offset = layouts[format].second;
+	return true;
+}
+
+///
+/// Decodes the records, the colour handling is a template parameter so the loop has no branches.
+///
+template <typename T, bool kColors, bool k16BitColors>
+void DecodeRecords(
+		const uint8_t* const records,
+		const size_t record_length,
+		const size_t count,
+		const std::array<double, 3>& scale,
+		const std::array<double, 3>& offset,
+		const size_t rgb_offset,
+		geometry::PointCloud<T>* const points
+		) {
+	T* const x = points->X().data();
+	T* const y = points->Y().data();
+	T* const z = points->Z().data();
+	T* const intensity = points->Intensities().data();
+	std::array<uint8_t, 3>* const rgb = kColors ? points->Colors().data() : nullptr;
+	for(size_t i = 0; i < count; ++i) {
+		const uint8_t* const record = records + i * record_length;
+		x[i] = static_cast<T>(Load<int32_t>(record) * scale[0] + offset[0]);
+		y[i] = static_cast<T>(Load<int32_t>(record + 4) * scale[1] + offset[1]);
+		z[i] = static_cast<T>(Load<int32_t>(record + 8) * scale[2] + offset[2]);
+		intensity[i] = static_cast<T>(Load<uint16_t>(record + kIntensityOffset));
+		if constexpr(kColors) {
+			for(size_t channel = 0; channel < 3; ++channel) {
+				const uint16_t value = Load<uint16_t>(record + rgb_offset + 2 * channel);
+				rgb[i][channel] = static_cast<uint8_t>(k16BitColors ? value >> 8 : std::min<uint16_t>(value, 255));
+			}
+		}
+	}
+}
+
+} // namespace
+
+namespace point_reader {
+
+template <typename T>
+LasReader<T>::LasReader(const std::string& file) {
+	fd_ = open(file.c_str(), O_RDONLY);
+	if(fd_ < 0)
+		return;
+
+	struct stat file_stat;
+	if(fstat(fd_, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < kMinHeaderSize)
+		return;
+	void* const mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+	if(mapped == MAP_FAILED)
+		return;
+	data_ = static_cast<const uint8_t*>(mapped);
+	size_ = static_cast<size_t>(file_stat.st_size);
+	if(std::memcmp(data_, "LASF", 4) != 0)
+		return;
+	madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL);
+
+	const size_t header_size = Load<uint16_t>(data_ + kHeaderSizeOffset);
+	point_data_offset_ = Load<uint32_t>(data_ + kPointDataOffsetOffset);
+	record_length_ = Load<uint16_t>(data_ + kRecordLengthOffset);
+	// LAZ files set the upper bits of the format, so they are rejected with the unknown formats
+	const uint8_t point_format = data_[kPointFormatOffset];
+	size_t min_record_length = 0;
+	if(!PointFormatLayout(point_format, &min_record_length, &rgb_offset_) || record_length_ < min_record_length)
+		return;
+
+	num_points_ = Load<uint32_t>(data_ + kLegacyNumPointsOffset);
+	if(data_[kVersionMinorOffset] >= 4 && header_size >= kHeaderSize14 && size_ >= kHeaderSize14)
+		num_points_ = static_cast<size_t>(Load<uint64_t>(data_ + kNumPointsOffset));
+	for(size_t k = 0; k < 3; ++k) {
+		scale_[k] = Load<double>(data_ + kScaleOffset + 8 * k);
+		offset_[k] = Load<double>(data_ + kOffsetOffset + 8 * k);
+	}
+
+	if(point_data_offset_ > size_ || num_points_ > (size_ - point_data_offset_) / record_length_)
+		return;
+
+	if(rgb_offset_ > 0) {
+		rgb_16_bit_ = false;
+		const size_t num_probes = std::min(num_points_, kColorProbePoints);
+		for(size_t i = 0; i < num_probes && !rgb_16_bit_; ++i) {
+			const uint8_t* const rgb = data_ + point_data_offset_ + i * record_length_ + rgb_offset_;
+			rgb_16_bit_ = Load<uint16_t>(rgb) > 255 || Load<uint16_t>(rgb + 2) > 255 || Load<uint16_t>(rgb + 4) > 255;
+		}
+	}
+	valid_ = true;
+}
+
+template <typename T>
+LasReader<T>::~LasReader() {
+	if(data_ != nullptr)
+		munmap(const_cast<uint8_t*>(data_), size_);
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+template <typename T>
+size_t LasReader<T>::NumRanges() const {
+	return (num_points_ + kPointsPerRange - 1) / kPointsPerRange;
+}
+
+template <typename T>
+bool LasReader<T>::ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const {
+	const size_t first = range * kPointsPerRange;
+	const size_t last = std::min(first + kPointsPerRange, num_points_);
+	if(!valid_ || first >= last)
+		return false;
+
+	if(HasColors() && !points->HasColors())
+		points->EnableColors();
+	if(!points->HasIntensities())
+		points->EnableIntensities();
+	points->Resize(last - first);
+
+	const uint8_t* const records = data_ + point_data_offset_ + first * record_length_;
+	if(!HasColors())
+		DecodeRecords<T, false, false>(records, record_length_, last - first, scale_, offset_, rgb_offset_, points);
+	else if(rgb_16_bit_)
+		DecodeRecords<T, true, true>(records, record_length_, last - first, scale_, offset_, rgb_offset_, points);
+	else
+		DecodeRecords<T, true, false>(records, record_length_, last - first, scale_, offset_, rgb_offset_, points);
+	return true;
+}
+
+template class LasReader<float>;
+template class LasReader<double>;
+
+} // namespace point_reader
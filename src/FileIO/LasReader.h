@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <FileIO/PointReader.h>
+
+namespace point_reader {
+
+///
+/// Memory mapped reader for uncompressed LAS 1.0 to 1.4 files with point data record formats 0 to 10.
+/// Ranges of point records are decoded independently straight from the mapped file: the scaled integer coordinates
+/// are converted with the scale and offset of the header, RGB of the formats that have it and the intensity.
+/// Other attributes and waveform packets are skipped. LAZ compressed files are not supported.
+///
+template <typename T>
+class LasReader : public PointReader<T> {
+public:
+	explicit LasReader(const std::string& file);
+	~LasReader();
+
+	LasReader(const LasReader&) = delete;
+	LasReader& operator=(const LasReader&) = delete;
+
+	bool IsOpen() const override final {
+		return valid_;
+	}
+
+	bool HasColors() const override final {
+		return rgb_offset_ > 0;
+	}
+
+	bool HasNormals() const override final {
+		return false;
+	}
+
+	bool HasIntensities() const override final {
+		return valid_;
+	}
+
+	size_t NumRanges() const override final;
+
+	bool ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const override final;
+
+	size_t NumPoints() const {
+		return num_points_;
+	}
+
+private:
+	int fd_ = -1;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+	bool valid_ = false;
+
+	size_t point_data_offset_ = 0;
+	size_t record_length_ = 0;
+	size_t num_points_ = 0;
+	std::array<double, 3> scale_ = {{1.0, 1.0, 1.0}};
+	std::array<double, 3> offset_ = {{0.0, 0.0, 0.0}};
+
+	// byte offset of red, green and blue in the record, 0 if the format has no colours
+	size_t rgb_offset_ = 0;
+	// many writers store 8 bit colours in the 16 bit fields, detected from the first records
+	bool rgb_16_bit_ = true;
+};
+
+} // namespace point_reader
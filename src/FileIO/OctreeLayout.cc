@@ -0,0 +1,136 @@
+#include "OctreeLayout.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include <FileIO/OctreeWriter.h>
+
+namespace octree_layout {
+
+namespace {
+
+///
+/// Spreads the lower 21 bits of v so there are two zero bits between each of them.
+///
+uint64_t SpreadBits(uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | (v << 32)) & 0x1f00000000ffff;
+	v = (v | (v << 16)) & 0x1f0000ff0000ff;
+	v = (v | (v << 8)) & 0x100f00f00f00f00f;
+	v = (v | (v << 4)) & 0x10c30c30c30c30c3;
+	v = (v | (v << 2)) & 0x1249249249249249;
+	return v;
+}
+
+} // namespace
+
+bool ParseLevelPolicy(
+		const std::string& name,
+		LevelPolicy* const policy
+		) {
+	if(name == "grouped") {
+		*policy = LevelPolicy::kGrouped;
+		return true;
+	}
+	if(name == "interleaved") {
+		*policy = LevelPolicy::kInterleaved;
+		return true;
+	}
+	return false;
+}
+
+uint64_t MortonCode(
+		const uint64_t hash,
+		const int64_t hash_range
+		) {
+	// inverse of the id computation of the key generator, the hash is built from non-negative shifted indices
+	const uint64_t range = static_cast<uint64_t>(2 * hash_range);
+	const uint64_t i = hash % range;
+	const uint64_t j = (hash / range) % range;
+	const uint64_t k = hash / (range * range);
+	return SpreadBits(i) | (SpreadBits(j) << 1) | (SpreadBits(k) << 2);
+}
+
+std::array<float, 3> BlockOrigin(
+		const uint64_t hash,
+		const float cell_size,
+		const int64_t hash_range
+		) {
+	const uint64_t range = static_cast<uint64_t>(2 * hash_range);
+	return {{
+		static_cast<float>(static_cast<int64_t>(hash % range) - hash_range) * cell_size,
+		static_cast<float>(static_cast<int64_t>((hash / range) % range) - hash_range) * cell_size,
+		static_cast<float>(static_cast<int64_t>(hash / (range * range)) - hash_range) * cell_size
+	}};
+}
+
+void SortBlocks(
+		const LevelPolicy policy,
+		std::vector<BlockEntry>* const blocks
+		) {
+	std::vector<std::pair<uint64_t, BlockEntry>> keyed;
+	keyed.reserve(blocks->size());
+	for(const BlockEntry& block : *blocks)
+		keyed.push_back({MortonCode(block.hash), block});
+
+	std::sort(keyed.begin(), keyed.end(), [&](const std::pair<uint64_t, BlockEntry>& a, const std::pair<uint64_t, BlockEntry>& b) {
+		if(policy == LevelPolicy::kGrouped)
+			return std::tie(a.first, a.second.hash, a.second.level) < std::tie(b.first, b.second.hash, b.second.level);
+		return std::tie(a.second.level, a.first, a.second.hash) < std::tie(b.second.level, b.first, b.second.hash);
+	});
+
+	for(size_t i = 0; i < keyed.size(); ++i)
+		(*blocks)[i] = keyed[i].second;
+}
+
+bool WriteOctree(
+		const std::string& octree_file,
+		const size_t num_levels,
+		const std::vector<BlockEntry>& blocks,
+		const std::function<bool(const BlockEntry&, std::vector<uint8_t>* const)>& read_payload
+		) {
+	std::vector<size_t> num_blocks_per_level(num_levels, 0);
+	for(const BlockEntry& block : blocks) {
+		if(block.level >= num_levels)
+			return false;
+		++num_blocks_per_level[block.level];
+	}
+
+	// written one block after the other, so the offsets follow the order of the blocks
+	octree_writer::OctreeWriter writer(octree_file, num_blocks_per_level);
+	std::vector<uint8_t> payload;
+	for(const BlockEntry& block : blocks) {
+		if(!read_payload(block, &payload) || payload.size() != block.size)
+			return false;
+		if(!writer.WriteBlocks({block}, payload.data()))
+			return false;
+	}
+	return writer.Finish();
+}
+
+bool RepackOctree(
+		const octree_reader::OctreeReader& octree_reader,
+		const std::string& octree_file,
+		const LevelPolicy policy
+		) {
+	std::vector<BlockEntry> blocks;
+	for(size_t level = 0; level < octree_reader.NumLevels(); ++level) {
+		for(const uint64_t hash : octree_reader.Hashes(level)) {
+			BlockEntry block;
+			block.level = level;
+			block.hash = hash;
+			block.size = octree_reader.GetSize(level, hash);
+			block.encoding = octree_reader.GetEncoding(level, hash);
+			block.codec = octree_reader.GetCodec(level, hash);
+			block.decoded_size = octree_reader.GetDecodedSize(level, hash);
+			blocks.push_back(block);
+		}
+	}
+	SortBlocks(policy, &blocks);
+
+	return WriteOctree(octree_file, octree_reader.NumLevels(), blocks, [&](const BlockEntry& block, std::vector<uint8_t>* const payload) {
+		return octree_reader.ReadBlock(block.level, block.hash, payload);
+	});
+}
+
+} // namespace octree_layout
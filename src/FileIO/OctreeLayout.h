@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <functional>
+#include <cstdint>
+
+#include <FileIO/PointRecords.h>
+#include <FileIO/BlockCodec.h>
+#include <FileIO/OctreeReader.h>
+
+namespace octree_layout {
+
+///
+/// Files start with the magic and the format version, followed by the index and the payloads.
+/// The index holds per level the number of blocks followed by (hash, offset, size, encoding, codec, decoded size) entries.
+/// Version 2 files have (hash, offset, size, encoding) entries and no compressed blocks.
+/// Legacy files have no magic and (hash, offset, size) entries, all payloads are point_records::XyzRgb.
+///
+constexpr uint64_t kMagic = 0x455254434f444f4cull; // "LODOCTRE"
+constexpr uint64_t kFormatVersion = 3;
+
+///
+/// Edge length of the level 0 cells, every block covers one of them.
+///
+constexpr float kLevel0CellSize = 10.0f;
+
+///
+/// How the levels of a block are placed relative to each other in the bundled file.
+/// kGrouped places all levels of a block next to each other, blocks follow in Morton order.
+/// kInterleaved places each level in its own section with the blocks in Morton order, so the levels of
+/// neighbouring blocks interleave block by block. Loading a whole level, e.g. level 0 at startup, is then one sequential read.
+///
+enum class LevelPolicy {
+	kGrouped,
+	kInterleaved
+};
+
+///
+/// Parses "grouped" or "interleaved". Returns false for unknown names.
+///
+bool ParseLevelPolicy(
+	const std::string& name,
+	LevelPolicy* const policy
+	);
+
+///
+/// Payload of one block at one level.
+/// size is the stored size, decoded_size the size of the records after decompression.
+///
+struct BlockEntry {
+	size_t level = 0;
+	uint64_t hash = 0;
+	size_t size = 0;
+	point_records::Encoding encoding = point_records::Encoding::kXyzRgb;
+	block_codec::Codec codec = block_codec::Codec::kNone;
+	size_t decoded_size = 0;
+};
+
+///
+/// Min corner of the level 0 cell of the block, the origin of quantized coordinates.
+///
+std::array<float, 3> BlockOrigin(
+	const uint64_t hash,
+	const float cell_size = kLevel0CellSize,
+	const int64_t hash_range = 100000
+	);
+
+///
+/// Morton code of the block position encoded in the hash.
+/// Blocks that are close in space get close codes.
+///
+uint64_t MortonCode(
+	const uint64_t hash,
+	const int64_t hash_range = 100000
+	);
+
+///
+/// Sorts the blocks into the order of their payloads in the file.
+///
+void SortBlocks(
+	const LevelPolicy policy,
+	std::vector<BlockEntry>* const blocks
+	);
+
+///
+/// Writes an .octree file: the index of num_levels levels followed by the payloads in the order of blocks.
+/// The payload of every block is requested through the callback, which returns false on errors.
+///
+bool WriteOctree(
+	const std::string& octree_file,
+	const size_t num_levels,
+	const std::vector<BlockEntry>& blocks,
+	const std::function<bool(const BlockEntry&, std::vector<uint8_t>* const)>& read_payload
+	);
+
+///
+/// Rewrites all blocks of an open octree into octree_file, with the payloads in the order of the policy.
+/// Returns false if a block could not be read or the file could not be written.
+///
+bool RepackOctree(
+	const octree_reader::OctreeReader& octree_reader,
+	const std::string& octree_file,
+	const LevelPolicy policy
+	);
+
+} // namespace octree_layout
@@ -1,25 +1,102 @@
 #include "OctreeReader.h"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include <FileIO/BinaryIO.h>
+#include <FileIO/OctreeLayout.h>
 
 namespace octree_reader {
 
-OctreeReader::OctreeReader(const std::string& octree_file) : octree_file_(octree_file) {
-	binary_io::BinaryReader bin_reader(octree_file);
+OctreeReader::OctreeReader(
+		const std::string& octree_file,
+		const AccessMode access_mode
+		) : octree_file_(octree_file) {
+	// the header is small, a buffer of a few pages reads it in one go
+	binary_io::BufferedBinaryReader bin_reader(octree_file, 1024 * 1024);
 
 	octree_offsets_.resize(7);
 	octree_sizes_.resize(7);
+	octree_encodings_.resize(7);
+	octree_codecs_.resize(7);
+
+	// files with the magic carry the encoding of every block, legacy files start directly with the index
+	uint64_t first_word = 0;
+	bin_reader.Read(&first_word);
+	const bool has_encodings = first_word == octree_layout::kMagic;
+	uint64_t version = 0;
+	if(has_encodings) {
+		if(!bin_reader.Read(&version) || version < 2 || version > octree_layout::kFormatVersion)
+			return;
+	} else {
+		bin_reader.Seek(0);
+	}
+	const bool has_codecs = version >= 3;
 
+	// per level the number of blocks followed by (hash, offset, size[, encoding[, codec, decoded size]]) entries.
+	// the counts are not trusted before they size an allocation: a count with more entries than the rest of the file
+	// holds means the index is corrupt, or the file is no octree at all and was taken for a legacy file
+	const size_t entry_words = has_codecs ? 6 : (has_encodings ? 4 : 3);
+	const size_t file_size = bin_reader.FileSize();
+	size_t position = has_encodings ? 2 * sizeof(uint64_t) : 0;
+	std::vector<uint64_t> entries;
 	for(size_t j = 0; j < 7; ++j) {
-		const size_t num_map_elements = bin_reader.Read<size_t>();
-		for(size_t k = 0; k < num_map_elements; ++k) {
-			const uint64_t hash = bin_reader.Read<uint64_t>();
-			const size_t offset = bin_reader.Read<size_t>();
-			const size_t size = bin_reader.Read<size_t>();
-			octree_offsets_[j].insert({hash, offset});
-			octree_sizes_[j].insert({hash, size});
+		size_t num_map_elements = 0;
+		if(!bin_reader.Read(&num_map_elements))
+			break;
+		position += sizeof(uint64_t);
+		if(position > file_size || num_map_elements > (file_size - position) / (entry_words * sizeof(uint64_t))) {
+			for(size_t level = 0; level < 7; ++level) {
+				octree_offsets_[level].clear();
+				octree_sizes_[level].clear();
+				octree_encodings_[level].clear();
+				octree_codecs_[level].clear();
+			}
+			return;
+		}
+		entries.resize(num_map_elements * entry_words);
+		entries.resize(bin_reader.ReadSpan(entries.data(), entries.size()) / entry_words * entry_words);
+		position += entries.size() * sizeof(uint64_t);
+		octree_offsets_[j].reserve(entries.size() / entry_words);
+		octree_sizes_[j].reserve(entries.size() / entry_words);
+		for(size_t k = 0; k < entries.size(); k += entry_words) {
+			octree_offsets_[j].insert({entries[k], static_cast<size_t>(entries[k + 1])});
+			octree_sizes_[j].insert({entries[k], static_cast<size_t>(entries[k + 2])});
+			if(has_encodings)
+				octree_encodings_[j].insert({entries[k], static_cast<point_records::Encoding>(entries[k + 3])});
+			if(has_codecs && entries[k + 4] != static_cast<uint64_t>(block_codec::Codec::kNone))
+				octree_codecs_[j].insert({entries[k], {static_cast<block_codec::Codec>(entries[k + 4]), static_cast<size_t>(entries[k + 5])}});
 		}
 	}	
+
+	fd_ = open(octree_file.c_str(), O_RDONLY);
+	valid_ = fd_ >= 0;
+
+	if(access_mode == AccessMode::kMemoryMapped && fd_ >= 0) {
+		struct stat file_stat;
+		if(fstat(fd_, &file_stat) == 0 && file_stat.st_size > 0) {
+			void* const mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+			if(mapped != MAP_FAILED) {
+				mapped_data_ = static_cast<uint8_t*>(mapped);
+				mapped_size_ = static_cast<size_t>(file_stat.st_size);
+				// blocks are fetched in view dependent order, read-ahead of the neighbouring file content does not help
+				madvise(mapped_data_, mapped_size_, MADV_RANDOM);
+			}
+		}
+	}
+}
+
+OctreeReader::~OctreeReader() {
+	if(mapped_data_ != nullptr)
+		munmap(mapped_data_, mapped_size_);
+	if(fd_ >= 0)
+		close(fd_);
 }
 
 std::string OctreeReader::GetBinFileName() const {
@@ -33,6 +110,13 @@ std::unordered_set<uint64_t> OctreeReader::AllHashes() const {
 	return all_hashes;
 }
 
+std::unordered_set<uint64_t> OctreeReader::Hashes(const size_t level) const {
+	std::unordered_set<uint64_t> hashes;
+	for(const auto& a : octree_offsets_.at(level))
+		hashes.insert(a.first);
+	return hashes;
+}
+
 size_t OctreeReader::GetOffset(
 		const size_t level,
 		const uint64_t hash
@@ -40,6 +124,30 @@ size_t OctreeReader::GetOffset(
 	return octree_offsets_.at(level).at(hash);
 }
 
+point_records::Encoding OctreeReader::GetEncoding(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	const auto it = octree_encodings_.at(level).find(hash);
+	return it == octree_encodings_.at(level).end() ? point_records::Encoding::kXyzRgb : it->second;
+}
+
+block_codec::Codec OctreeReader::GetCodec(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	const auto it = octree_codecs_.at(level).find(hash);
+	return it == octree_codecs_.at(level).end() ? block_codec::Codec::kNone : it->second.first;
+}
+
+size_t OctreeReader::GetDecodedSize(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	const auto it = octree_codecs_.at(level).find(hash);
+	return it == octree_codecs_.at(level).end() ? GetSize(level, hash) : it->second.second;
+}
+
 size_t OctreeReader::GetSize(
 		const size_t level,
 		const uint64_t hash
@@ -47,4 +155,99 @@ size_t OctreeReader::GetSize(
 	return octree_sizes_.at(level).at(hash);
 }
 
+bool OctreeReader::ReadBlock(
+		const size_t level,
+		const uint64_t hash,
+		std::vector<uint8_t>* const buffer
+		) const {
+	if(fd_ < 0)
+		return false;
+
+	const size_t offset = GetOffset(level, hash);
+	const size_t size = GetSize(level, hash);
+	buffer->resize(size);
+
+	if(mapped_data_ != nullptr) {
+		if(offset + size > mapped_size_)
+			return false;
+		std::memcpy(buffer->data(), mapped_data_ + offset, size);
+		return true;
+	}
+
+	size_t num_bytes_read = 0;
+	while(num_bytes_read < size) {
+		const ssize_t ret = pread(fd_, buffer->data() + num_bytes_read, size - num_bytes_read, 
+			static_cast<off_t>(offset + num_bytes_read));
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0)
+			return false;
+		num_bytes_read += static_cast<size_t>(ret);
+	}
+	return true;
+}
+
+BlockSpan OctreeReader::GetBlockSpan(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	BlockSpan span;
+	if(mapped_data_ == nullptr)
+		return span;
+
+	const size_t offset = GetOffset(level, hash);
+	const size_t size = GetSize(level, hash);
+	if(offset + size > mapped_size_)
+		return span;
+
+	span.data = mapped_data_ + offset;
+	span.size = size;
+	return span;
+}
+
+void OctreeReader::Prefetch(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	const size_t offset = GetOffset(level, hash);
+	const size_t size = GetSize(level, hash);
+
+	if(mapped_data_ == nullptr) {
+		if(fd_ >= 0)
+			posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+		return;
+	}
+
+	// widen to page boundaries
+	const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = offset / page_size * page_size;
+	const size_t end = std::min(mapped_size_, offset + size);
+	if(end > begin)
+		madvise(mapped_data_ + begin, end - begin, MADV_WILLNEED);
+}
+
+void OctreeReader::Evict(
+		const size_t level,
+		const uint64_t hash
+		) const {
+	const size_t offset = GetOffset(level, hash);
+	const size_t size = GetSize(level, hash);
+
+	// narrow to page boundaries so pages shared with neighbouring blocks stay
+	const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t begin = (offset + page_size - 1) / page_size * page_size;
+	const size_t end = (offset + size) / page_size * page_size;
+	if(end <= begin)
+		return;
+
+	if(mapped_data_ == nullptr) {
+		if(fd_ >= 0)
+			posix_fadvise(fd_, static_cast<off_t>(begin), static_cast<off_t>(end - begin), POSIX_FADV_DONTNEED);
+		return;
+	}
+
+	if(end <= mapped_size_)
+		madvise(mapped_data_ + begin, end - begin, MADV_DONTNEED);
+}
+
 } // namespace octree_reader
\ No newline at end of file
@@ -4,9 +4,36 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <cstdint>
+
+#include <FileIO/PointRecords.h>
+#include <FileIO/BlockCodec.h>
 
 namespace octree_reader {
 
+///
+/// How the block payloads are accessed.
+/// kRead uses positional reads into caller buffers.
+/// kMemoryMapped maps the file so payloads can be accessed without a copy and the page cache is shared between processes.
+///
+enum class AccessMode {
+	kRead,
+	kMemoryMapped
+};
+
+///
+/// Non-owning view of a block payload inside the mapped file.
+///
+struct BlockSpan {
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+
+	bool Empty() const {
+		return data == nullptr;
+	}
+};
+
 ///
 /// Class that provides an interface to retrieve the binary file offsets to read the .octree file.
 ///
@@ -15,8 +42,31 @@ public:
 	///
 	/// Contructor.
 	/// Computes the content of the member variables.
+	/// Falls back to kRead if the file can not be mapped.
 	///
-	OctreeReader(const std::string& octree_file);
+	OctreeReader(
+		const std::string& octree_file,
+		const AccessMode access_mode = AccessMode::kRead
+		);
+
+	///
+	/// Destructor. Closes the file and unmaps it.
+	///
+	~OctreeReader();
+
+	///
+	/// Returns false if the file could not be opened, has an unsupported format version or a corrupt index.
+	/// A reader that is not open has no blocks.
+	///
+	bool IsOpen() const {
+		return valid_;
+	}
+
+	///
+	/// The reader owns an open file handle.
+	///
+	OctreeReader(const OctreeReader&) = delete;
+	OctreeReader& operator=(const OctreeReader&) = delete;
 
 	///
 	/// Returns the file name.
@@ -28,6 +78,18 @@ public:
 	///
 	std::unordered_set<uint64_t> AllHashes() const;
 
+	///
+	/// Returns the hashes of the blocks stored at the given level.
+	///
+	std::unordered_set<uint64_t> Hashes(const size_t level) const;
+
+	///
+	/// Number of levels in the file.
+	///
+	size_t NumLevels() const {
+		return octree_offsets_.size();
+	}
+
 	///
 	/// Offset accesssor.
 	///
@@ -44,10 +106,85 @@ public:
 		const uint64_t hash
 		) const;
 
+	///
+	/// Encoding accessor. Blocks of legacy files are point_records::Encoding::kXyzRgb.
+	///
+	point_records::Encoding GetEncoding(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
+	///
+	/// Codec accessor. Blocks of files before format version 3 are not compressed.
+	///
+	block_codec::Codec GetCodec(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
+	///
+	/// Size of the records of a block after decompression, the stored size for uncompressed blocks.
+	///
+	size_t GetDecodedSize(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
+	///
+	/// Reads the payload of a block with a single positional read on the file handle kept open for
+	/// the lifetime of the reader. The buffer is resized to the block size and can be reused between calls.
+	/// Safe to call from multiple threads with different buffers.
+	///
+	bool ReadBlock(
+		const size_t level,
+		const uint64_t hash,
+		std::vector<uint8_t>* const buffer
+		) const;
+
+	///
+	/// Returns true if the file is memory mapped.
+	///
+	bool IsMemoryMapped() const {
+		return mapped_data_ != nullptr;
+	}
+
+	///
+	/// Zero-copy access to the payload of a block. Empty if the file is not memory mapped.
+	/// The span is valid for the lifetime of the reader.
+	///
+	BlockSpan GetBlockSpan(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
+	///
+	/// Hints the OS to read the block into the page cache ahead of its use.
+	///
+	void Prefetch(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
+	///
+	/// Hints the OS that the pages of the block are not needed anymore.
+	/// Only pages that lie completely inside the block are released, neighbouring blocks are not affected.
+	///
+	void Evict(
+		const size_t level,
+		const uint64_t hash
+		) const;
+
 private:
 	const std::string octree_file_;
 	std::vector<std::unordered_map<uint64_t, size_t>> octree_offsets_;
 	std::vector<std::unordered_map<uint64_t, size_t>> octree_sizes_;
+	std::vector<std::unordered_map<uint64_t, point_records::Encoding>> octree_encodings_;
+	// codec and decoded size, only for compressed blocks
+	std::vector<std::unordered_map<uint64_t, std::pair<block_codec::Codec, size_t>>> octree_codecs_;
+	bool valid_ = false;
+	int fd_ = -1;
+	uint8_t* mapped_data_ = nullptr;
+	size_t mapped_size_ = 0;
 };
 
 } // namespace octree_reader
\ No newline at end of file
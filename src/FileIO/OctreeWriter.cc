@@ -0,0 +1,112 @@
+#include "OctreeWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace octree_writer {
+
+OctreeWriter::OctreeWriter(
+		const std::string& octree_file,
+		const std::vector<size_t>& num_blocks_per_level
+		) : num_blocks_per_level_(num_blocks_per_level),
+			index_(num_blocks_per_level.size()) {
+	fd_ = open(octree_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	// magic and version, then per level the number of blocks followed by (hash, offset, size, encoding, codec, decoded size) entries
+	size_t header_size = 2 * sizeof(uint64_t);
+	for(const size_t num_blocks : num_blocks_per_level_)
+		header_size += sizeof(size_t) + num_blocks * kIndexEntrySize;
+	next_offset_ = AlignUp(header_size);
+}
+
+OctreeWriter::~OctreeWriter() {
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+bool OctreeWriter::WriteBlocks(
+		const std::vector<octree_layout::BlockEntry>& blocks,
+		const uint8_t* const data
+		) {
+	size_t total_size = 0;
+	for(const octree_layout::BlockEntry& block : blocks) {
+		if(block.level >= index_.size()) {
+			good_ = false;
+			return false;
+		}
+		total_size += block.size;
+	}
+
+	const size_t offset = next_offset_.fetch_add(AlignUp(total_size));
+	if(!WriteAt(offset, data, total_size))
+		return false;
+
+	std::lock_guard<std::mutex> lock(index_mutex_);
+	size_t block_offset = offset;
+	for(const octree_layout::BlockEntry& block : blocks) {
+		index_[block.level].push_back({
+			block.hash,
+			block_offset,
+			block.size,
+			static_cast<uint64_t>(block.encoding),
+			static_cast<uint64_t>(block.codec),
+			block.codec == block_codec::Codec::kNone ? block.size : block.decoded_size
+		});
+		block_offset += block.size;
+	}
+	return true;
+}
+
+bool OctreeWriter::Finish() {
+	std::lock_guard<std::mutex> lock(index_mutex_);
+
+	std::vector<uint8_t> header(2 * sizeof(uint64_t));
+	std::memcpy(header.data(), &octree_layout::kMagic, sizeof(uint64_t));
+	std::memcpy(header.data() + sizeof(uint64_t), &octree_layout::kFormatVersion, sizeof(uint64_t));
+	for(size_t level = 0; level < index_.size(); ++level) {
+		if(index_[level].size() != num_blocks_per_level_[level]) {
+			good_ = false;
+			return false;
+		}
+
+		std::sort(index_[level].begin(), index_[level].end(), [](const IndexEntry& a, const IndexEntry& b) {
+			return a.offset < b.offset;
+		});
+
+		const size_t num_blocks = index_[level].size();
+		const size_t first = header.size();
+		header.resize(first + sizeof(size_t) + num_blocks * kIndexEntrySize);
+		uint8_t* out = header.data() + first;
+		std::memcpy(out, &num_blocks, sizeof(size_t));
+		out += sizeof(size_t);
+		static_assert(sizeof(IndexEntry) == kIndexEntrySize, "index entries are written as they are laid out in memory");
+		std::memcpy(out, index_[level].data(), num_blocks * kIndexEntrySize);
+	}
+
+	return WriteAt(0, header.data(), header.size());
+}
+
+bool OctreeWriter::WriteAt(
+		size_t offset,
+		const uint8_t* data,
+		size_t n
+		) {
+	while(fd_ >= 0 && good_ && n > 0) {
+		const ssize_t ret = pwrite(fd_, data, n, static_cast<off_t>(offset));
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0) {
+			good_ = false;
+			break;
+		}
+		data += ret;
+		offset += static_cast<size_t>(ret);
+		n -= static_cast<size_t>(ret);
+	}
+	return Good();
+}
+
+} // namespace octree_writer
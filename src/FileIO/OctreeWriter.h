@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include <FileIO/OctreeLayout.h>
+
+namespace octree_writer {
+
+///
+/// Writes an .octree file in a single pass.
+/// The index at the start of the file is reserved up front from the number of blocks per level and written by Finish.
+/// Payloads are written by any number of threads into ranges handed out by an atomic offset allocator,
+/// so every payload touches the disk exactly once.
+/// Ranges start on kPayloadAlignment byte boundaries, so aligned records stay aligned when the file is memory mapped.
+///
+class OctreeWriter {
+public:
+	OctreeWriter(
+		const std::string& octree_file,
+		const std::vector<size_t>& num_blocks_per_level
+		);
+	~OctreeWriter();
+
+	OctreeWriter(const OctreeWriter&) = delete;
+	OctreeWriter& operator=(const OctreeWriter&) = delete;
+
+	///
+	/// Returns false if the file could not be opened or a write failed.
+	///
+	bool Good() const {
+		return fd_ >= 0 && good_;
+	}
+
+	///
+	/// Reserves one contiguous range for the blocks and writes their payloads, which are concatenated in data
+	/// in the order of the blocks. Safe to call from multiple threads.
+	///
+	bool WriteBlocks(
+		const std::vector<octree_layout::BlockEntry>& blocks,
+		const uint8_t* const data
+		);
+
+	///
+	/// Writes the index. The blocks of a level are listed in file order.
+	/// Fails if the number of written blocks of a level differs from the reserved one.
+	///
+	bool Finish();
+
+private:
+	///
+	/// Positional write of all n bytes.
+	///
+	bool WriteAt(
+		size_t offset,
+		const uint8_t* data,
+		size_t n
+		);
+
+	// index entry of a written block, in file layout
+	struct IndexEntry {
+		uint64_t hash;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t encoding;
+		uint64_t codec;
+		uint64_t decoded_size;
+	};
+	static constexpr size_t kIndexEntrySize = 6 * sizeof(uint64_t);
+	static constexpr size_t kPayloadAlignment = 16;
+
+	///
+	/// Rounds up to the next multiple of kPayloadAlignment.
+	///
+	static size_t AlignUp(const size_t n) {
+		return (n + kPayloadAlignment - 1) / kPayloadAlignment * kPayloadAlignment;
+	}
+
+	int fd_ = -1;
+	std::atomic<bool> good_{true};
+	const std::vector<size_t> num_blocks_per_level_;
+	std::atomic<size_t> next_offset_{0};
+	std::mutex index_mutex_;
+	std::vector<std::vector<IndexEntry>> index_;
+};
+
+} // namespace octree_writer
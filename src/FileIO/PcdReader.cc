@@ -0,0 +1,309 @@
+#include "PcdReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// points are decoded in ranges of this many
+constexpr size_t kPointsPerRange = 65536;
+
+// a PCD header is a handful of short lines, anything longer is not one
+constexpr size_t kMaxHeaderSize = 64 * 1024;
+
+///
+/// Scalar type of a PCD field from its TYPE and SIZE, false for the 8 byte integers that have no scalar type.
+///
+bool FieldScalarType(
+		const char type,
+		const size_t size,
+		ply_reader::ScalarType* const scalar_type
+		) {
+	if(type == 'F' && size == 4) *scalar_type = ply_reader::ScalarType::kFloat32;
+	else if(type == 'F' && size == 8) *scalar_type = ply_reader::ScalarType::kFloat64;
+	else if(type == 'U' && size == 1) *scalar_type = ply_reader::ScalarType::kUint8;
+	else if(type == 'U' && size == 2) *scalar_type = ply_reader::ScalarType::kUint16;
+	else if(type == 'U' && size == 4) *scalar_type = ply_reader::ScalarType::kUint32;
+	else if(type == 'I' && size == 1) *scalar_type = ply_reader::ScalarType::kInt8;
+	else if(type == 'I' && size == 2) *scalar_type = ply_reader::ScalarType::kInt16;
+	else if(type == 'I' && size == 4) *scalar_type = ply_reader::ScalarType::kInt32;
+	else return false;
+	return true;
+}
+
+///
+/// LZF decompression as written by PCL (liblzf format without block headers).
+/// Returns false if the data is corrupt or does not decompress to exactly output_size bytes.
+///
+bool LzfDecompress(
+		const uint8_t* const input,
+		const size_t input_size,
+		uint8_t* const output,
+		const size_t output_size
+		) {
+	const uint8_t* in = input;
+	const uint8_t* const in_end = input + input_size;
+	uint8_t* out = output;
+	uint8_t* const out_end = output + output_size;
+	while(in < in_end) {
+		size_t control = *in++;
+		if(control < 32) {
+			// literal run of control + 1 bytes
+			const size_t length = control + 1;
+			if(length > static_cast<size_t>(out_end - out) || length > static_cast<size_t>(in_end - in))
+				return false;
+			std::memcpy(out, in, length);
+			out += length;
+			in += length;
+		} else {
+			// back reference, the copy may overlap its source
+			size_t length = control >> 5;
+			if(length == 7) {
+				if(in >= in_end)
+					return false;
+				length += *in++;
+			}
+			if(in >= in_end)
+				return false;
+			const size_t distance = ((control & 0x1f) << 8) + *in++ + 1;
+			length += 2;
+			if(distance > static_cast<size_t>(out - output) || length > static_cast<size_t>(out_end - out))
+				return false;
+			const uint8_t* reference = out - distance;
+			for(size_t k = 0; k < length; ++k)
+				*out++ = *reference++;
+		}
+	}
+	return out == out_end;
+}
+
+} // namespace
+
+namespace point_reader {
+
+template <typename T>
+PcdReader<T>::PcdReader(const std::string& file) {
+	fd_ = open(file.c_str(), O_RDONLY);
+	if(fd_ < 0)
+		return;
+
+	struct stat file_stat;
+	if(fstat(fd_, &file_stat) != 0 || file_stat.st_size <= 0)
+		return;
+	void* const mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+	if(mapped == MAP_FAILED)
+		return;
+	data_ = static_cast<const uint8_t*>(mapped);
+	size_ = static_cast<size_t>(file_stat.st_size);
+	madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL);
+
+	size_t data_offset = 0;
+	if(!ParseHeader(&data_offset))
+		return;
+
+	xyz_ = {{FindField({"x"}), FindField({"y"}), FindField({"z"})}};
+	normal_ = {{FindField({"normal_x", "nx"}), FindField({"normal_y", "ny"}), FindField({"normal_z", "nz"})}};
+	intensity_ = FindField({"intensity"});
+	for(size_t f = 0; f < fields_.size() && rgb_ < 0; ++f)
+		if((fields_[f].name == "rgb" || fields_[f].name == "rgba") && fields_[f].size == 4)
+			rgb_ = static_cast<int>(f);
+	if(xyz_[0] < 0 || xyz_[1] < 0 || xyz_[2] < 0)
+		return;
+
+	if(!compressed_) {
+		if(data_offset > size_ || (record_size_ > 0 && num_points_ > (size_ - data_offset) / record_size_))
+			return;
+		points_data_ = data_ + data_offset;
+	} else if(num_points_ > 0) {
+		uint32_t compressed_size = 0;
+		uint32_t decompressed_size = 0;
+		if(data_offset + 2 * sizeof(uint32_t) > size_)
+			return;
+		std::memcpy(&compressed_size, data_ + data_offset, sizeof(uint32_t));
+		std::memcpy(&decompressed_size, data_ + data_offset + sizeof(uint32_t), sizeof(uint32_t));
+		data_offset += 2 * sizeof(uint32_t);
+		if(compressed_size > size_ - data_offset || record_size_ == 0 || decompressed_size / record_size_ != num_points_)
+			return;
+		decompressed_.resize(decompressed_size);
+		if(!LzfDecompress(data_ + data_offset, compressed_size, decompressed_.data(), decompressed_.size()))
+			return;
+		points_data_ = decompressed_.data();
+	}
+	valid_ = true;
+}
+
+template <typename T>
+PcdReader<T>::~PcdReader() {
+	if(data_ != nullptr)
+		munmap(const_cast<uint8_t*>(data_), size_);
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+template <typename T>
+size_t PcdReader<T>::NumRanges() const {
+	return (num_points_ + kPointsPerRange - 1) / kPointsPerRange;
+}
+
+template <typename T>
+bool PcdReader<T>::ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const {
+	const size_t first = range * kPointsPerRange;
+	const size_t last = std::min(first + kPointsPerRange, num_points_);
+	if(!valid_ || first >= last)
+		return false;
+
+	if(HasColors() && !points->HasColors())
+		points->EnableColors();
+	if(HasNormals() && !points->HasNormals())
+		points->EnableNormals();
+	if(HasIntensities() && !points->HasIntensities())
+		points->EnableIntensities();
+	points->Resize(last - first);
+	const size_t count = last - first;
+
+	const auto decode = [&](const int field, T* const destination) {
+		ply_reader::ScalarType type = ply_reader::ScalarType::kFloat32;
+		FieldScalarType(fields_[static_cast<size_t>(field)].type, fields_[static_cast<size_t>(field)].size, &type);
+		const size_t stride = FieldStride(field);
+		ply_reader::DecodeScalarColumn(type, false, FieldBase(field) + first * stride, stride, count, destination);
+	};
+	decode(xyz_[0], points->X().data());
+	decode(xyz_[1], points->Y().data());
+	decode(xyz_[2], points->Z().data());
+	if(HasNormals()) {
+		decode(normal_[0], points->Nx().data());
+		decode(normal_[1], points->Ny().data());
+		decode(normal_[2], points->Nz().data());
+	}
+	if(HasIntensities())
+		decode(intensity_, points->Intensities().data());
+
+	if(HasColors()) {
+		// packed little endian as b, g, r, a whether the field is declared float or unsigned
+		const size_t stride = FieldStride(rgb_);
+		const uint8_t* const base = FieldBase(rgb_) + first * stride;
+		std::array<uint8_t, 3>* const rgb = points->Colors().data();
+		for(size_t i = 0; i < count; ++i) {
+			const uint8_t* const packed = base + i * stride;
+			rgb[i] = {{packed[2], packed[1], packed[0]}};
+		}
+	}
+	return true;
+}
+
+template <typename T>
+bool PcdReader<T>::ParseHeader(size_t* const data_offset) {
+	size_t width = 0;
+	size_t height = 1;
+	bool has_points = false;
+	std::vector<size_t> sizes;
+	std::vector<char> types;
+	std::vector<size_t> counts;
+	const size_t header_end = std::min(size_, kMaxHeaderSize);
+	size_t position = 0;
+	while(position < header_end) {
+		const void* const line_end = std::memchr(data_ + position, '\n', header_end - position);
+		if(line_end == nullptr)
+			return false;
+		const size_t next_position = static_cast<size_t>(static_cast<const uint8_t*>(line_end) - data_) + 1;
+		std::stringstream ss(std::string(reinterpret_cast<const char*>(data_ + position), next_position - 1 - position));
+		position = next_position;
+
+		std::string keyword;
+		ss >> keyword;
+		if(keyword.empty() || keyword[0] == '#') {
+			continue;
+		} else if(keyword == "VERSION") {
+			is_pcd_ = true;
+		} else if(keyword == "FIELDS" || keyword == "COLUMNS") {
+			is_pcd_ = true;
+			Field field;
+			while(ss >> field.name)
+				fields_.push_back(field);
+		} else if(keyword == "SIZE") {
+			size_t value;
+			while(ss >> value)
+				sizes.push_back(value);
+		} else if(keyword == "TYPE") {
+			char value;
+			while(ss >> value)
+				types.push_back(value);
+		} else if(keyword == "COUNT") {
+			size_t value;
+			while(ss >> value)
+				counts.push_back(value);
+		} else if(keyword == "WIDTH") {
+			ss >> width;
+		} else if(keyword == "HEIGHT") {
+			ss >> height;
+		} else if(keyword == "POINTS") {
+			ss >> num_points_;
+			has_points = !ss.fail();
+		} else if(keyword == "DATA") {
+			std::string data_type;
+			ss >> data_type;
+			if(data_type == "binary_compressed")
+				compressed_ = true;
+			else if(data_type != "binary")
+				return false;
+			*data_offset = position;
+			break;
+		}
+	}
+	if(!is_pcd_ || *data_offset == 0 || fields_.empty() || sizes.size() != fields_.size() || types.size() != fields_.size()
+		|| (!counts.empty() && counts.size() != fields_.size()))
+		return false;
+	if(!has_points)
+		num_points_ = width * height;
+
+	size_t offset = 0;
+	for(size_t f = 0; f < fields_.size(); ++f) {
+		Field& field = fields_[f];
+		field.size = sizes[f];
+		field.type = types[f];
+		field.count = counts.empty() ? 1 : counts[f];
+		field.offset = offset;
+		offset += field.size * field.count;
+	}
+	record_size_ = offset;
+	size_t column_offset = 0;
+	for(Field& field : fields_) {
+		field.column_offset = column_offset;
+		column_offset += field.size * field.count * num_points_;
+	}
+	return true;
+}
+
+template <typename T>
+const uint8_t* PcdReader<T>::FieldBase(const int field) const {
+	const Field& f = fields_[static_cast<size_t>(field)];
+	return points_data_ + (compressed_ ? f.column_offset : f.offset);
+}
+
+template <typename T>
+size_t PcdReader<T>::FieldStride(const int field) const {
+	const Field& f = fields_[static_cast<size_t>(field)];
+	return compressed_ ? f.size * f.count : record_size_;
+}
+
+template <typename T>
+int PcdReader<T>::FindField(const std::vector<std::string>& names) const {
+	ply_reader::ScalarType type;
+	for(size_t f = 0; f < fields_.size(); ++f)
+		if(std::find(names.begin(), names.end(), fields_[f].name) != names.end() && FieldScalarType(fields_[f].type, fields_[f].size, &type))
+			return static_cast<int>(f);
+	return -1;
+}
+
+template class PcdReader<float>;
+template class PcdReader<double>;
+
+} // namespace point_reader
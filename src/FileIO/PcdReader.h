@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <FileIO/PointReader.h>
+#include <FileIO/PlyReader.h>
+
+namespace point_reader {
+
+///
+/// Reader for PCL .pcd files with binary or binary_compressed data.
+/// Binary files are memory mapped and their records decoded in place. binary_compressed files store the fields
+/// column after column in a single LZF stream, it is decompressed once when the file is opened and the columns are
+/// then decoded from the decompressed buffer. Either way ranges of points are decoded independently, column by
+/// column straight into the point batches.
+/// Reads x, y, z, the packed rgb or rgba colour, normal_x, normal_y, normal_z and intensity. ASCII data is not
+/// supported.
+///
+template <typename T>
+class PcdReader : public PointReader<T> {
+public:
+	explicit PcdReader(const std::string& file);
+	~PcdReader();
+
+	PcdReader(const PcdReader&) = delete;
+	PcdReader& operator=(const PcdReader&) = delete;
+
+	///
+	/// True if the file has a PCD header, even if its data can not be read.
+	///
+	bool IsPcd() const {
+		return is_pcd_;
+	}
+
+	bool IsOpen() const override final {
+		return valid_;
+	}
+
+	bool HasColors() const override final {
+		return rgb_ >= 0;
+	}
+
+	bool HasNormals() const override final {
+		return normal_[0] >= 0 && normal_[1] >= 0 && normal_[2] >= 0;
+	}
+
+	bool HasIntensities() const override final {
+		return intensity_ >= 0;
+	}
+
+	size_t NumRanges() const override final;
+
+	bool ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const override final;
+
+	size_t NumPoints() const {
+		return num_points_;
+	}
+
+private:
+	struct Field {
+		std::string name;
+		size_t size = 4;
+		char type = 'F';
+		size_t count = 1;
+		// position of the field in a binary record and of its column in decompressed data
+		size_t offset = 0;
+		size_t column_offset = 0;
+	};
+
+	bool ParseHeader(size_t* const data_offset);
+
+	///
+	/// Position of the first element of the field of the first point, and the distance between points.
+	///
+	const uint8_t* FieldBase(const int field) const;
+
+	size_t FieldStride(const int field) const;
+
+	///
+	/// Index of the first field with one of the names that has a numeric type, -1 if there is none.
+	///
+	int FindField(const std::vector<std::string>& names) const;
+
+	int fd_ = -1;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+	bool is_pcd_ = false;
+	bool valid_ = false;
+
+	std::vector<Field> fields_;
+	size_t num_points_ = 0;
+	size_t record_size_ = 0;
+	bool compressed_ = false;
+
+	// the point data, in the mapped file for binary files and decompressed for binary_compressed ones
+	const uint8_t* points_data_ = nullptr;
+	std::vector<uint8_t> decompressed_;
+
+	std::array<int, 3> xyz_ = {{-1, -1, -1}};
+	int rgb_ = -1;
+	std::array<int, 3> normal_ = {{-1, -1, -1}};
+	int intensity_ = -1;
+};
+
+} // namespace point_reader
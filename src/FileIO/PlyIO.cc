@@ -1,21 +1,96 @@
 #include "PlyIO.h"
 
+#include <algorithm>
+#include <atomic>
+
+#include "PlyReader.h"
+#include "PlyWriter.h"
+#include "TextPointReader.h"
+
 namespace {
-	// TODO the standalone function shall become deprecated and replaced with the Binary IO class
-	template <typename T>
-	void AddDataToBinaryBlob(const T data, uint8_t * const binary_data_blob, size_t * const idx)
-	{
-		std::memcpy(&(binary_data_blob[*idx]), &data, sizeof(T));
-		*idx += sizeof(T);
+	///
+	/// Streams the vertices through the writer in batches, OpenMP parallel, so the encoded vertices never exist for the
+	/// whole file at once. fill copies the vertices [first, last) into a batch that has the columns of the layout.
+	///
+	template <typename T, typename Fill>
+	bool WriteVertexBatches(
+			ply_writer::PlyWriter<T>* const writer,
+			const ply_writer::PlyLayout& layout,
+			const Fill& fill
+			) {
+		const size_t batch_size = ply_writer::PlyWriter<T>::kVerticesPerBatch;
+		const size_t num_batches = (layout.num_vertices + batch_size - 1) / batch_size;
+		std::atomic<bool> ok{true};
+		#pragma omp parallel
+		{
+			geometry::PointCloud<T> batch;
+			if(layout.normals)
+				batch.EnableNormals();
+			if(layout.colors)
+				batch.EnableColors();
+			if(layout.intensities)
+				batch.EnableIntensities();
+			#pragma omp for schedule(static)
+			for(size_t b = 0; b < num_batches; ++b) {
+				const size_t first = b * batch_size;
+				const size_t last = std::min(first + batch_size, layout.num_vertices);
+				batch.Resize(last - first);
+				fill(first, last, &batch);
+				if(!writer->WriteVertices(first, batch))
+					ok = false;
+			}
+		}
+		return ok;
 	}
 
-	template <typename T>
-	T GetDataFromBinaryBlob(const uint8_t * const binary_data_blob, size_t * const idx)
-	{
-		T data;
-		std::memcpy(&data, &(binary_data_blob[*idx]), sizeof(T));
-		*idx += sizeof(T);
-		return data;
+	///
+	/// Writes points stored as Eigen vectors of 3 or 4 coordinates, the fourth is dropped.
+	///
+	template <typename T, typename Points>
+	bool WriteEigenPly(
+			const std::string& filename,
+			const Points& points,
+			const std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>>* const normals,
+			const std::vector<std::array<uint8_t, 3> >* const colors,
+			const std::vector<std::array<size_t, 3> >* const triangles,
+			const std::vector<T>* const intensities
+			) {
+		// first, check that the sizes match
+		if(normals != nullptr && points.size() != normals->size())
+			return false;
+		if(colors != nullptr && points.size() != colors->size())
+			return false;
+		if(intensities != nullptr && points.size() != intensities->size())
+			return false;
+
+		ply_writer::PlyLayout layout;
+		layout.num_vertices = points.size();
+		layout.normals = (normals != nullptr);
+		layout.colors = (colors != nullptr);
+		layout.intensities = (intensities != nullptr);
+		layout.triangles = (triangles != nullptr);
+		layout.num_triangles = (triangles != nullptr ? triangles->size() : 0);
+		ply_writer::PlyWriter<T> writer(filename, layout);
+
+		const bool vertices_ok = WriteVertexBatches(&writer, layout, [&](const size_t first, const size_t last, geometry::PointCloud<T>* const batch) {
+			for(size_t i = first; i < last; ++i) {
+				batch->X()[i - first] = points[i](0);
+				batch->Y()[i - first] = points[i](1);
+				batch->Z()[i - first] = points[i](2);
+				if(normals != nullptr) {
+					batch->Nx()[i - first] = (*normals)[i](0);
+					batch->Ny()[i - first] = (*normals)[i](1);
+					batch->Nz()[i - first] = (*normals)[i](2);
+				}
+				if(colors != nullptr)
+					batch->Colors()[i - first] = (*colors)[i];
+				if(intensities != nullptr)
+					batch->Intensities()[i - first] = (*intensities)[i];
+			}
+		});
+		if(triangles != nullptr)
+			writer.WriteTriangles(0, *triangles);
+		return vertices_ok && writer.Finish();
 	}
 } // namespace
 
@@ -30,89 +105,7 @@ bool PlyIO<T>::WritePly(
 		const std::vector<std::array<size_t, 3> >* const triangles,
 		const std::vector<T>* const intensities
 		) {
-	// first, check that the sizes match
-	if(normals != nullptr && points.size() != normals->size())
-		return false;
-	if(colors != nullptr && points.size() != colors->size())
-		return false;
-	if(intensities != nullptr && points.size() != intensities->size())
-		return false;
-
-	std::ofstream ofs(filename.c_str());
-
-	ofs << "ply" << std::endl;
-	ofs << "format binary_little_endian 1.0" << std::endl;
-	ofs << "element vertex " << points.size() << std::endl;
-	std::string precision_type;
-	if(sizeof(T) == sizeof(float)) precision_type = "float";
-	else if(sizeof(T) == sizeof(double)) precision_type = "double";
-	else return false;
-	ofs << "property " + precision_type + " x" << std::endl;
-	ofs << "property " + precision_type + " y" << std::endl;
-	ofs << "property " + precision_type + " z" << std::endl;
-	if(normals != nullptr) {
-		ofs << "property " + precision_type + " nx" << std::endl;
-		ofs << "property " + precision_type + " ny" << std::endl;
-		ofs << "property " + precision_type + " nz" << std::endl;
-	}
-	if(colors != nullptr) {
-		ofs << "property uchar red" << std::endl;
-		ofs << "property uchar green" << std::endl;
-		ofs << "property uchar blue" << std::endl;
-		ofs << "property uchar alpha" << std::endl;
-	}
-	if(intensities != nullptr) {
-		ofs << "property " + precision_type + " intensity_value" << std::endl;
-	}
-	if(triangles != nullptr) {
-		ofs << "element face " << triangles->size() << std::endl;
-		ofs << "property list uchar int vertex_indices" << std::endl;
-	}
-	ofs << "end_header" << std::endl;
-
-
-	size_t block_size_points = 3 * sizeof(T);
-	if(normals != nullptr) block_size_points += 3 * sizeof(T);
-	if(colors != nullptr) block_size_points += 4 * sizeof(uint8_t);
-	if(intensities != nullptr) block_size_points += sizeof(T);
-
-	size_t block_size_triangles = sizeof(uint8_t) + 3 * sizeof(int);
-
-    std::string data;
-    data.resize(points.size() * block_size_points + (triangles != nullptr ? triangles->size() : 0) * block_size_triangles);
-    uint8_t * const data_ptr = reinterpret_cast<uint8_t * const>( &(data[0]) );
-    size_t data_ptr_id = 0;
-
-	for(size_t i=0; i < points.size(); ++i) {
-		for(Eigen::Index j=0; j < 3; ++j)
-			AddDataToBinaryBlob<T>(points[i](j), data_ptr, &data_ptr_id);
-		
-		if(normals != nullptr)
-			for(Eigen::Index j=0; j < 3; ++j)
-				AddDataToBinaryBlob<T>((*normals)[i](j), data_ptr, &data_ptr_id);
-		
-		if(colors != nullptr) {
-			for(size_t j=0; j < 3; ++j)
-				AddDataToBinaryBlob<uint8_t>((*colors)[i][j], data_ptr, &data_ptr_id);
-			AddDataToBinaryBlob<uint8_t>(static_cast<uint8_t>(255), data_ptr, &data_ptr_id);
-		}
-
-		if(intensities != nullptr)
-			AddDataToBinaryBlob<T>((*intensities)[i], data_ptr, &data_ptr_id);
-	}
-
-	if(triangles != nullptr) {
-		for(size_t i=0; i < triangles->size(); ++i) {
-			AddDataToBinaryBlob<uint8_t>(static_cast<uint8_t>(3), data_ptr, &data_ptr_id);
-			for(size_t j=0; j < 3; ++j)
-				AddDataToBinaryBlob<int>(static_cast<int>((*triangles)[i][j]), data_ptr, &data_ptr_id);
-		}
-	}
-
-	ofs << data;
-
-	ofs.close();
-	return true;
+	return WriteEigenPly<T>(filename, points, normals, colors, triangles, intensities);
 }
 
 template <typename T>
@@ -124,11 +117,7 @@ bool PlyIO<T>::WritePly(
 		const std::vector<std::array<size_t, 3> >* const triangles,
 		const std::vector<T>* const intensities
 		) {
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> points_vec3(points.size());
-	#pragma omp parallel for
-	for(size_t i=0; i < points.size(); ++i) 
-		points_vec3[i] = points[i].template block<3, 1>(0,0);
-	return WritePly(filename, points_vec3, normals, colors, triangles, intensities);
+	return WriteEigenPly<T>(filename, points, normals, colors, triangles, intensities);
 }
 
 
@@ -207,25 +196,47 @@ bool PlyIO<T>::WritePly(
 		const std::vector<geometry::Point<T>>& point_structs,
 		const std::vector<std::array<size_t, 3> >* const triangles
 		) {
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> points;
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> normals;
-	std::vector<std::array<uint8_t, 3> > colors;
-	std::vector<T> intensities;
-
+	// normals and colors are written if the points have them, all points or none must have them
+	size_t num_normals = 0;
+	size_t num_colors = 0;
+	#pragma omp parallel for reduction(+:num_normals, num_colors)
 	for(size_t i=0; i < point_structs.size(); ++i) {
-		points.push_back(Eigen::Matrix<T, 3, 1>(point_structs[i].xyz_(0), point_structs[i].xyz_(1), point_structs[i].xyz_(2)));
-		intensities.push_back(point_structs[i].i_);
 		if(point_structs[i].n_.squaredNorm() > 0.1)
-			normals.push_back(point_structs[i].n_);
+			++num_normals;
 		if(point_structs[i].c_[3] != 0)
-			colors.push_back({point_structs[i].c_[0], point_structs[i].c_[1], point_structs[i].c_[2]});
+			++num_colors;
 	}
+	if((num_normals > 0 && num_normals != point_structs.size()) || (num_colors > 0 && num_colors != point_structs.size()))
+		return false;
 
-	const std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> * const normals_ptr = (normals.size() > 0 ? &normals : nullptr);
-	const std::vector<std::array<uint8_t, 3>> * const colors_ptr = (colors.size() > 0 ? &colors : nullptr);
-	const std::vector<T> * const intensities_ptr = (intensities.size() > 0 ? &intensities : nullptr);
-
-	return WritePly(filename, points, normals_ptr, colors_ptr, triangles, intensities_ptr);
+	ply_writer::PlyLayout layout;
+	layout.num_vertices = point_structs.size();
+	layout.normals = (num_normals > 0);
+	layout.colors = (num_colors > 0);
+	layout.intensities = !point_structs.empty();
+	layout.triangles = (triangles != nullptr);
+	layout.num_triangles = (triangles != nullptr ? triangles->size() : 0);
+	ply_writer::PlyWriter<T> writer(filename, layout);
+
+	const bool vertices_ok = WriteVertexBatches(&writer, layout, [&](const size_t first, const size_t last, geometry::PointCloud<T>* const batch) {
+		for(size_t i = first; i < last; ++i) {
+			const geometry::Point<T>& point = point_structs[i];
+			batch->X()[i - first] = point.xyz_(0);
+			batch->Y()[i - first] = point.xyz_(1);
+			batch->Z()[i - first] = point.xyz_(2);
+			if(layout.normals) {
+				batch->Nx()[i - first] = point.n_(0);
+				batch->Ny()[i - first] = point.n_(1);
+				batch->Nz()[i - first] = point.n_(2);
+			}
+			if(layout.colors)
+				batch->Colors()[i - first] = {{point.c_[0], point.c_[1], point.c_[2]}};
+			batch->Intensities()[i - first] = point.i_;
+		}
+	});
+	if(triangles != nullptr)
+		writer.WriteTriangles(0, *triangles);
+	return vertices_ok && writer.Finish();
 }
 
 template <typename T>
@@ -237,137 +248,27 @@ bool PlyIO<T>::ReadPly(
 		std::vector<std::array<size_t, 3> >* const output_triangles,
 		std::vector<T> * const output_intensities
 		) {
-	std::ifstream ifs(filename.c_str(), std::ifstream::binary);
-
-	bool file_contains_coordinates = false;
-	bool file_contains_normals = false;
-	bool file_contains_colors = false;
-	bool file_contains_triangles = false;
-	bool file_contains_intensities = false;
-
-	size_t num_vertices = 0;
-	size_t num_triangles = 0;
-
-
-	if (ifs.is_open()) {
-		while(ifs.good()) {
-			std::string line;
-			getline (ifs, line);
-			if(line.empty())
-				continue;
-
-			std::stringstream ss(line);
-			std::string first_word;
-			ss >> first_word;
-
-			if(first_word.compare("element") == 0) {
-				std::string element_type;
-				ss >> element_type;
-				if(element_type.compare("vertex") == 0) {
-					ss >> num_vertices;
-				} else if(element_type.compare("face") == 0) {
-					file_contains_triangles = true;
-					ss >> num_triangles;
-				} else {
-					return false;
-				}
-			} else if(first_word.compare("property") == 0) {
-				std::string second_word, third_word;
-				ss >> second_word >> third_word;
-				if(third_word.compare("x") == 0)
-					file_contains_coordinates = true;
-				else if(third_word.compare("nx") == 0)
-					file_contains_normals = true;
-				else if(third_word.compare("red") == 0)
-					file_contains_colors = true;
-				else if(third_word.compare("intensity_value") == 0)
-					file_contains_intensities = true;
-			} else if(first_word.compare("end_header") == 0) {
-				break;
-			}
-		}
-	} else {
-		return false;
-	}
-	
-	if(!file_contains_coordinates)
-		return false;
-
-	size_t block_size_points = 3 * sizeof(T);
-	if(file_contains_normals)
-		block_size_points += 3 * sizeof(T);
-	if(file_contains_colors)
-		block_size_points += 4 * sizeof(uint8_t);
-	if(file_contains_intensities)
-		block_size_points += sizeof(T);
-
-	size_t block_size_triangles = sizeof(uint8_t) + 3 * sizeof(int);
-
-	std::vector<char> raw_data(num_vertices * block_size_points + (file_contains_triangles ? num_triangles : 0) * block_size_triangles + 1);
-
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> points;
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> normals;
-	std::vector<std::array<uint8_t, 3> > colors;
+	geometry::PointCloud<T> cloud;
 	std::vector<std::array<size_t, 3> > triangles;
-	std::vector<T> intensities;
-
-	points.resize(num_vertices);
-	if(file_contains_normals)
-		normals.resize(num_vertices);
-	if(file_contains_colors)
-		colors.resize(num_vertices);
-	if(file_contains_triangles)
-		triangles.resize(num_triangles);
-	if(file_contains_intensities)
-		intensities.resize(num_vertices);
-
-	ifs.read(&(raw_data[0]), static_cast<int64_t>(raw_data.size()));
-	ifs.close();
-
-	const uint8_t * const data_ptr = reinterpret_cast<const uint8_t *>(&(raw_data[0]));
-	size_t data_ptr_idx = 0;
-
-	for(size_t i=0; i < num_vertices; ++i) {
-		for(Eigen::Index j=0; j < 3; ++j)
-			points[i](j) = GetDataFromBinaryBlob<T>(data_ptr, &data_ptr_idx);
-
-		if(file_contains_normals)
-			for(Eigen::Index j=0; j < 3; ++j)
-				normals[i](j) = GetDataFromBinaryBlob<T>(data_ptr, &data_ptr_idx);
-
-		if(file_contains_colors) {
-			for(size_t j=0; j < 3; ++j)
-				colors[i][j] = GetDataFromBinaryBlob<uint8_t>(data_ptr, &data_ptr_idx);
-			const uint8_t alpha_color = GetDataFromBinaryBlob<uint8_t>(data_ptr, &data_ptr_idx);
-
-			if(alpha_color != 255)
-				return false;
-		}
+	if(!ReadPly(filename, &cloud, &triangles))
+		return false;
 
-		if(file_contains_intensities)
-			intensities[i] = GetDataFromBinaryBlob<T>(data_ptr, &data_ptr_idx);
+	if( output_points != nullptr ) {
+		output_points->resize(cloud.Size());
+		for(size_t i=0; i < cloud.Size(); ++i)
+			(*output_points)[i] = cloud.Xyz(i);
 	}
-
-	if(file_contains_triangles) {
-		for(size_t i=0; i < num_triangles; ++i) {
-			const uint8_t num_list_elements = GetDataFromBinaryBlob<uint8_t>(data_ptr, &data_ptr_idx);
-			if( num_list_elements != 3 )
-				return false;
-			for(size_t j=0; j < 3; ++j)
-				triangles[i][j] = static_cast<size_t>(GetDataFromBinaryBlob<int>(data_ptr, &data_ptr_idx));
-		}
+	if( output_normals != nullptr ) {
+		output_normals->resize(cloud.HasNormals() ? cloud.Size() : 0);
+		for(size_t i=0; i < output_normals->size(); ++i)
+			(*output_normals)[i] = cloud.Normal(i);
 	}
-
-	if( output_points != nullptr ) 
-		*output_points = points;
-	if( output_normals != nullptr ) 
-		*output_normals = normals;
 	if( output_colors != nullptr ) 
-		*output_colors = colors;
+		output_colors->assign(cloud.Colors().begin(), cloud.Colors().end());
 	if( output_triangles != nullptr ) 
-		*output_triangles = triangles;
+		*output_triangles = std::move(triangles);
 	if( output_intensities != nullptr ) 
-		*output_intensities = intensities;
+		output_intensities->assign(cloud.Intensities().begin(), cloud.Intensities().end());
 
 	return true;
 }
@@ -379,43 +280,107 @@ bool PlyIO<T>::ReadPly(
 		std::vector<std::array<size_t, 3> >* const output_triangles
 		)
 {
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> points;
-	std::vector<Eigen::Matrix<T, 3, 1>, Eigen::aligned_allocator<Eigen::Matrix<T, 3, 1>>> normals;
-	std::vector<std::array<uint8_t, 3> > colors;
-	std::vector<std::array<size_t, 3> > triangles;
-	std::vector<T> intensities;
-
-	const bool ret = ReadPly(filename, &points, &normals, &colors, &triangles, &intensities);
+	geometry::PointCloud<T> cloud;
+	const bool ret = ReadPly(filename, &cloud, output_triangles);
 
 	if( ! ret )
 		return false;
 	
 	output_points->clear();
-	output_points->resize(points.size());
+	output_points->resize(cloud.Size());
 
-	for(size_t i=0; i < points.size(); ++i)
+	for(size_t i=0; i < cloud.Size(); ++i)
 	{
-		(*output_points)[i].xyz_(0) = points[i](0);
-		(*output_points)[i].xyz_(1) = points[i](1);
-		(*output_points)[i].xyz_(2) = points[i](2);
+		(*output_points)[i].xyz_(0) = cloud.X()[i];
+		(*output_points)[i].xyz_(1) = cloud.Y()[i];
+		(*output_points)[i].xyz_(2) = cloud.Z()[i];
 		(*output_points)[i].xyz_(3) = 1.0;
-		if( normals.size() != 0 ) 
-			(*output_points)[i].n_ = normals[i];
-		if( intensities.size() != 0 ) 
-			(*output_points)[i].i_ = intensities[i];
-		if( colors.size() != 0 ) {
-			(*output_points)[i].c_[0] = colors[i][0];
-			(*output_points)[i].c_[1] = colors[i][1];
-			(*output_points)[i].c_[2] = colors[i][2];
+		if( cloud.HasNormals() ) 
+			(*output_points)[i].n_ = cloud.Normal(i);
+		if( cloud.HasIntensities() ) 
+			(*output_points)[i].i_ = cloud.Intensities()[i];
+		if( cloud.HasColors() ) {
+			(*output_points)[i].c_[0] = cloud.Colors()[i][0];
+			(*output_points)[i].c_[1] = cloud.Colors()[i][1];
+			(*output_points)[i].c_[2] = cloud.Colors()[i][2];
 			(*output_points)[i].c_[3] = 1;
 		}
 	}
 
-	if( output_triangles != nullptr ) *output_triangles = triangles;
-
 	return true;
 }
 
+template <typename T>
+bool PlyIO<T>::WritePly(
+		const std::string& filename,
+		const geometry::PointCloud<T>& cloud,
+		const std::vector<std::array<size_t, 3> >* const triangles
+		) {
+	ply_writer::PlyLayout layout;
+	layout.num_vertices = cloud.Size();
+	layout.normals = cloud.HasNormals();
+	layout.colors = cloud.HasColors();
+	layout.intensities = cloud.HasIntensities();
+	layout.triangles = (triangles != nullptr);
+	layout.num_triangles = (triangles != nullptr ? triangles->size() : 0);
+	ply_writer::PlyWriter<T> writer(filename, layout);
+
+	writer.WriteVertices(0, cloud);
+	if(triangles != nullptr)
+		writer.WriteTriangles(0, *triangles);
+	return writer.Finish();
+}
+
+template <typename T>
+bool PlyIO<T>::ReadPly(
+		const std::string& filename,
+		geometry::PointCloud<T>* const output_cloud,
+		std::vector<std::array<size_t, 3> >* const output_triangles
+		) {
+	const ply_reader::PlyReader reader(filename);
+	if(!reader.IsOpen()) {
+		// ASCII files are parsed in parallel by the text reader
+		const point_reader::TextPointReader<T> text_reader(filename);
+		if(!text_reader.IsOpen() || !text_reader.IsPly())
+			return false;
+		geometry::PointCloud<T> cloud;
+		if(!text_reader.ReadAll(&cloud))
+			return false;
+		if(output_triangles != nullptr && !text_reader.ReadFaces(output_triangles))
+			return false;
+		*output_cloud = std::move(cloud);
+		return true;
+	}
+	if(!reader.HasCoordinates())
+		return false;
+
+	geometry::PointCloud<T> cloud;
+	if(reader.HasColors())
+		cloud.EnableColors();
+	if(reader.HasNormals())
+		cloud.EnableNormals();
+	if(reader.HasIntensities())
+		cloud.EnableIntensities();
+	cloud.Resize(reader.NumVertices());
+
+	ply_reader::VertexColumns<T> columns;
+	columns.x = cloud.X().data();
+	columns.y = cloud.Y().data();
+	columns.z = cloud.Z().data();
+	columns.rgb = cloud.HasColors() ? cloud.Colors().data() : nullptr;
+	columns.nx = cloud.HasNormals() ? cloud.Nx().data() : nullptr;
+	columns.ny = cloud.HasNormals() ? cloud.Ny().data() : nullptr;
+	columns.nz = cloud.HasNormals() ? cloud.Nz().data() : nullptr;
+	columns.intensity = cloud.HasIntensities() ? cloud.Intensities().data() : nullptr;
+	if(!reader.ReadVertices(columns))
+		return false;
+
+	if(output_triangles != nullptr && !reader.ReadFaces(output_triangles))
+		return false;
+
+	*output_cloud = std::move(cloud);
+	return true;
+}
 
 
 template class PlyIO<float>;
@@ -8,6 +8,7 @@
 #include <Eigen/Core>
 #include <Eigen/StdVector>
 #include <Geometry/Point.h>
+#include <Geometry/PointCloud.h>
 
 #include "BinaryIO.h"
 
@@ -30,6 +31,18 @@ public:
 		std::vector<std::array<size_t, 3>>* const output_triangles = nullptr
 		);
 
+	// methods using the geometry::PointCloud<T> container, vertices are converted directly from and to its columns
+	static bool WritePly(
+		const std::string& filename,
+		const geometry::PointCloud<T>& cloud,
+		const std::vector<std::array<size_t, 3>>* const triangles = nullptr
+		);
+
+	static bool ReadPly(
+		const std::string & filename,
+		geometry::PointCloud<T>* const output_cloud,
+		std::vector<std::array<size_t, 3>>* const output_triangles = nullptr
+		);
 
 	// lower level accessors
 
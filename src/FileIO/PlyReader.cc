@@ -0,0 +1,668 @@
+#include "PlyReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// vertices are decoded in ranges of this many by the parallel reader
+constexpr size_t kVerticesPerRange = 65536;
+
+template <size_t kSize>
+struct UnsignedOfSize;
+template <> struct UnsignedOfSize<1> { using Type = uint8_t; };
+template <> struct UnsignedOfSize<2> { using Type = uint16_t; };
+template <> struct UnsignedOfSize<4> { using Type = uint32_t; };
+template <> struct UnsignedOfSize<8> { using Type = uint64_t; };
+
+inline uint8_t ByteSwap(const uint8_t value) { return value; }
+inline uint16_t ByteSwap(const uint16_t value) { return __builtin_bswap16(value); }
+inline uint32_t ByteSwap(const uint32_t value) { return __builtin_bswap32(value); }
+inline uint64_t ByteSwap(const uint64_t value) { return __builtin_bswap64(value); }
+
+///
+/// Loads a scalar from an unaligned position, byte swapped for big endian files.
+/// The swap is a single bswap instruction, so swapped loads stay branch free and vectorize like plain ones.
+///
+template <typename S, bool kSwap>
+S Load(const uint8_t* const p) {
+	S value;
+	if(kSwap) {
+		typename UnsignedOfSize<sizeof(S)>::Type bits;
+		std::memcpy(&bits, p, sizeof(S));
+		bits = ByteSwap(bits);
+		std::memcpy(&value, &bits, sizeof(S));
+	} else {
+		std::memcpy(&value, p, sizeof(S));
+	}
+	return value;
+}
+
+template <typename T, typename S, bool kSwap>
+void DecodeScalars(
+		const uint8_t* const base,
+		const size_t stride,
+		const size_t count,
+		T* const destination
+		) {
+	for(size_t i = 0; i < count; ++i)
+		destination[i] = static_cast<T>(Load<S, kSwap>(base + i * stride));
+}
+
+///
+/// Colour channel from a scalar. Floating point colours are in [0, 1], 16 bit colours use the upper byte.
+///
+template <typename S>
+uint8_t ColorChannel(const S value) {
+	if(std::is_floating_point<S>::value)
+		return static_cast<uint8_t>(std::lround(std::min(std::max(static_cast<double>(value), 0.0), 1.0) * 255.0));
+	if(std::is_same<S, uint16_t>::value)
+		return static_cast<uint8_t>(static_cast<uint16_t>(value) >> 8);
+	return static_cast<uint8_t>(std::min(std::max(static_cast<double>(value), 0.0), 255.0));
+}
+
+template <typename S, bool kSwap>
+void DecodeColorChannel(
+		const uint8_t* const base,
+		const size_t stride,
+		const size_t count,
+		const size_t channel,
+		std::array<uint8_t, 3>* const destination
+		) {
+	for(size_t i = 0; i < count; ++i)
+		destination[i][channel] = ColorChannel(Load<S, kSwap>(base + i * stride));
+}
+
+///
+/// Calls function with a value of the C++ type of the scalar type, the branch is taken once per column.
+///
+template <typename Function>
+void DispatchScalarType(const ply_reader::ScalarType type, const Function& function) {
+	switch(type) {
+	case ply_reader::ScalarType::kInt8: function(int8_t()); break;
+	case ply_reader::ScalarType::kUint8: function(uint8_t()); break;
+	case ply_reader::ScalarType::kInt16: function(int16_t()); break;
+	case ply_reader::ScalarType::kUint16: function(uint16_t()); break;
+	case ply_reader::ScalarType::kInt32: function(int32_t()); break;
+	case ply_reader::ScalarType::kUint32: function(uint32_t()); break;
+	case ply_reader::ScalarType::kFloat32: function(float()); break;
+	case ply_reader::ScalarType::kFloat64: function(double()); break;
+	}
+}
+
+void DecodeColorColumn(
+		const ply_reader::Property& property,
+		const bool swap,
+		const uint8_t* const records,
+		const size_t stride,
+		const size_t count,
+		const size_t channel,
+		std::array<uint8_t, 3>* const destination
+		) {
+	DispatchScalarType(property.type, [&](auto scalar) {
+		using S = decltype(scalar);
+		if(swap)
+			DecodeColorChannel<S, true>(records + property.offset, stride, count, channel, destination);
+		else
+			DecodeColorChannel<S, false>(records + property.offset, stride, count, channel, destination);
+	});
+}
+
+template <bool kValue>
+using Flag = std::integral_constant<bool, kValue>;
+
+///
+/// Stand in scalar type for a property the specialized decoder does not read.
+///
+struct NoScalar {};
+
+template <typename Function>
+void DispatchFlag(const bool value, const Function& function) {
+	if(value)
+		function(Flag<true>());
+	else
+		function(Flag<false>());
+}
+
+///
+/// Calls function with float or double for the floating point types, returns false for the others.
+///
+template <typename Function>
+bool DispatchFloatType(const ply_reader::ScalarType type, const Function& function) {
+	switch(type) {
+	case ply_reader::ScalarType::kFloat32: function(float()); return true;
+	case ply_reader::ScalarType::kFloat64: function(double()); return true;
+	default: return false;
+	}
+}
+
+///
+/// Byte offsets of the vertex properties in the record.
+///
+struct VertexOffsets {
+	std::array<size_t, 3> xyz = {{0, 0, 0}};
+	std::array<size_t, 3> rgb = {{0, 0, 0}};
+	std::array<size_t, 3> normal = {{0, 0, 0}};
+	size_t intensity = 0;
+};
+
+///
+/// Decoder for one vertex layout into the start of the columns: coordinates of type SCoordinate, optional uchar colors, optional normals of
+/// the coordinate type and an optional intensity of type SIntensity. Everything that varies between files is a
+/// template parameter, so the loop over the records has no branches, narrowing double to float and byte swapping
+/// are inlined, and all columns are written in one pass over the records.
+///
+template <typename T, typename SCoordinate, bool kSwap, bool kColors, bool kNormals, typename SIntensity>
+void DecodeVertexRecords(
+		const VertexOffsets& offsets,
+		const uint8_t* const records,
+		const size_t stride,
+		const size_t count,
+		const ply_reader::VertexColumns<T>& columns
+		) {
+	T* const x = columns.x;
+	T* const y = columns.y;
+	T* const z = columns.z;
+	std::array<uint8_t, 3>* const rgb = columns.rgb;
+	T* const nx = columns.nx;
+	T* const ny = columns.ny;
+	T* const nz = columns.nz;
+	T* const intensity = columns.intensity;
+
+	for(size_t i = 0; i < count; ++i) {
+		const uint8_t* const record = records + i * stride;
+		x[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.xyz[0]));
+		y[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.xyz[1]));
+		z[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.xyz[2]));
+		if constexpr(kColors)
+			rgb[i] = {{record[offsets.rgb[0]], record[offsets.rgb[1]], record[offsets.rgb[2]]}};
+		if constexpr(kNormals) {
+			nx[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.normal[0]));
+			ny[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.normal[1]));
+			nz[i] = static_cast<T>(Load<SCoordinate, kSwap>(record + offsets.normal[2]));
+		}
+		if constexpr(!std::is_same<SIntensity, NoScalar>::value)
+			intensity[i] = static_cast<T>(Load<SIntensity, kSwap>(record + offsets.intensity));
+	}
+}
+
+///
+/// The columns starting at vertex first, null columns stay null.
+///
+template <typename T>
+ply_reader::VertexColumns<T> OffsetColumns(
+		const ply_reader::VertexColumns<T>& columns,
+		const size_t first
+		) {
+	const auto offset = [first](auto* const column) {
+		return column == nullptr ? column : column + first;
+	};
+	ply_reader::VertexColumns<T> range_columns;
+	range_columns.x = offset(columns.x);
+	range_columns.y = offset(columns.y);
+	range_columns.z = offset(columns.z);
+	range_columns.rgb = offset(columns.rgb);
+	range_columns.nx = offset(columns.nx);
+	range_columns.ny = offset(columns.ny);
+	range_columns.nz = offset(columns.nz);
+	range_columns.intensity = offset(columns.intensity);
+	return range_columns;
+}
+
+} // namespace
+
+namespace ply_reader {
+
+size_t ScalarSize(const ScalarType type) {
+	switch(type) {
+	case ScalarType::kInt8:
+	case ScalarType::kUint8:
+		return 1;
+	case ScalarType::kInt16:
+	case ScalarType::kUint16:
+		return 2;
+	case ScalarType::kInt32:
+	case ScalarType::kUint32:
+	case ScalarType::kFloat32:
+		return 4;
+	case ScalarType::kFloat64:
+		return 8;
+	}
+	return 0;
+}
+
+bool ParseScalarType(
+		const std::string& name,
+		ScalarType* const type
+		) {
+	if(name == "char" || name == "int8") *type = ScalarType::kInt8;
+	else if(name == "uchar" || name == "uint8") *type = ScalarType::kUint8;
+	else if(name == "short" || name == "int16") *type = ScalarType::kInt16;
+	else if(name == "ushort" || name == "uint16") *type = ScalarType::kUint16;
+	else if(name == "int" || name == "int32") *type = ScalarType::kInt32;
+	else if(name == "uint" || name == "uint32") *type = ScalarType::kUint32;
+	else if(name == "float" || name == "float32") *type = ScalarType::kFloat32;
+	else if(name == "double" || name == "float64") *type = ScalarType::kFloat64;
+	else return false;
+	return true;
+}
+
+template <typename T>
+void DecodeScalarColumn(
+		const ScalarType type,
+		const bool swap,
+		const uint8_t* const base,
+		const size_t stride,
+		const size_t count,
+		T* const destination
+		) {
+	DispatchScalarType(type, [&](auto scalar) {
+		using S = decltype(scalar);
+		if(swap)
+			DecodeScalars<T, S, true>(base, stride, count, destination);
+		else
+			DecodeScalars<T, S, false>(base, stride, count, destination);
+	});
+}
+
+int Element::FindProperty(const std::vector<std::string>& names) const {
+	for(size_t i = 0; i < properties.size(); ++i)
+		if(std::find(names.begin(), names.end(), properties[i].name) != names.end())
+			return static_cast<int>(i);
+	return -1;
+}
+
+bool ParseHeader(
+		const uint8_t* const data,
+		const size_t size,
+		Header* const header
+		) {
+	*header = Header();
+	bool has_format = false;
+	size_t position = 0;
+	for(size_t line_number = 0; position < size; ++line_number) {
+		const void* const line_end = std::memchr(data + position, '\n', size - position);
+		if(line_end == nullptr)
+			return false;
+		const size_t next_position = static_cast<size_t>(static_cast<const uint8_t*>(line_end) - data) + 1;
+		std::string line(reinterpret_cast<const char*>(data + position), next_position - 1 - position);
+		position = next_position;
+		if(!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		std::stringstream ss(line);
+		std::string keyword;
+		ss >> keyword;
+
+		if(line_number == 0) {
+			if(keyword != "ply")
+				return false;
+		} else if(keyword == "format") {
+			std::string format;
+			ss >> format;
+			if(format == "ascii") header->format = Format::kAscii;
+			else if(format == "binary_little_endian") header->format = Format::kBinaryLittleEndian;
+			else if(format == "binary_big_endian") header->format = Format::kBinaryBigEndian;
+			else return false;
+			has_format = true;
+		} else if(keyword == "element") {
+			Element element;
+			ss >> element.name >> element.count;
+			if(ss.fail())
+				return false;
+			header->elements.push_back(element);
+		} else if(keyword == "property") {
+			if(header->elements.empty())
+				return false;
+			Property property;
+			std::string type_name;
+			ss >> type_name;
+			if(type_name == "list") {
+				std::string count_type_name;
+				ss >> count_type_name >> type_name;
+				if(!ParseScalarType(count_type_name, &property.count_type))
+					return false;
+				property.is_list = true;
+			}
+			ss >> property.name;
+			if(ss.fail() || !ParseScalarType(type_name, &property.type))
+				return false;
+			header->elements.back().properties.push_back(property);
+		} else if(keyword == "end_header") {
+			header->data_offset = position;
+			for(Element& element : header->elements) {
+				size_t offset = 0;
+				bool fixed_size = true;
+				for(Property& property : element.properties) {
+					property.offset = offset;
+					fixed_size = fixed_size && !property.is_list;
+					offset += ScalarSize(property.type);
+				}
+				element.record_size = fixed_size ? offset : 0;
+			}
+			return has_format;
+		}
+		// comment, obj_info and unknown keywords carry no layout information
+	}
+	return false;
+}
+
+PlyReader::PlyReader(const std::string& ply_file) {
+	fd_ = open(ply_file.c_str(), O_RDONLY);
+	if(fd_ < 0)
+		return;
+
+	struct stat file_stat;
+	if(fstat(fd_, &file_stat) != 0 || file_stat.st_size <= 0)
+		return;
+	void* const mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+	if(mapped == MAP_FAILED)
+		return;
+	data_ = static_cast<const uint8_t*>(mapped);
+	size_ = static_cast<size_t>(file_stat.st_size);
+	// the vertex section is consumed front to back, let the kernel read ahead aggressively
+	madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL);
+
+	if(!ParseHeader(data_, size_, &header_) || header_.format == Format::kAscii)
+		return;
+
+	int vertex_element = -1;
+	for(size_t i = 0; i < header_.elements.size(); ++i) {
+		if(header_.elements[i].name == "vertex" && vertex_element < 0)
+			vertex_element = static_cast<int>(i);
+		else if(header_.elements[i].name == "face" && face_element_ < 0)
+			face_element_ = static_cast<int>(i);
+	}
+	if(vertex_element < 0)
+		return;
+	vertex_element_ = static_cast<size_t>(vertex_element);
+
+	const Element& vertex = header_.elements[vertex_element_];
+	if(vertex.record_size == 0 && vertex.count > 0)
+		return;
+	if(!ElementOffset(vertex_element_, &vertex_offset_))
+		return;
+	if(vertex.count > 0 && (size_ - vertex_offset_) / vertex.record_size < vertex.count)
+		return;
+
+	xyz_ = {{vertex.FindProperty({"x"}), vertex.FindProperty({"y"}), vertex.FindProperty({"z"})}};
+	rgb_ = {{
+		vertex.FindProperty({"red", "r", "diffuse_red"}),
+		vertex.FindProperty({"green", "g", "diffuse_green"}),
+		vertex.FindProperty({"blue", "b", "diffuse_blue"})
+	}};
+	normal_ = {{vertex.FindProperty({"nx", "normal_x"}), vertex.FindProperty({"ny", "normal_y"}), vertex.FindProperty({"nz", "normal_z"})}};
+	intensity_ = vertex.FindProperty({"intensity_value", "intensity", "scalar_intensity"});
+
+	const auto property_type = [&](const int property) {
+		return vertex.properties[static_cast<size_t>(property)].type;
+	};
+	const auto is_float_type = [](const ScalarType type) {
+		return type == ScalarType::kFloat32 || type == ScalarType::kFloat64;
+	};
+	if(HasCoordinates()) {
+		layout_.coordinate_type = property_type(xyz_[0]);
+		layout_.coordinates = is_float_type(layout_.coordinate_type)
+			&& property_type(xyz_[1]) == layout_.coordinate_type && property_type(xyz_[2]) == layout_.coordinate_type;
+	}
+	layout_.uchar_colors = HasColors()
+		&& property_type(rgb_[0]) == ScalarType::kUint8
+		&& property_type(rgb_[1]) == ScalarType::kUint8
+		&& property_type(rgb_[2]) == ScalarType::kUint8;
+	layout_.coordinate_normals = HasNormals()
+		&& property_type(normal_[0]) == layout_.coordinate_type
+		&& property_type(normal_[1]) == layout_.coordinate_type
+		&& property_type(normal_[2]) == layout_.coordinate_type;
+	if(HasIntensities()) {
+		layout_.intensity_type = property_type(intensity_);
+		layout_.float_intensity = is_float_type(layout_.intensity_type);
+	}
+	valid_ = true;
+}
+
+PlyReader::~PlyReader() {
+	if(data_ != nullptr)
+		munmap(const_cast<uint8_t*>(data_), size_);
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+template <typename T>
+bool PlyReader::ReadVertices(
+		const VertexColumns<T>& columns,
+		const size_t first,
+		const size_t last
+		) const {
+	return ReadVertexRange(OffsetColumns(columns, first), first, last);
+}
+
+template <typename T>
+bool PlyReader::ReadVertexRange(
+		const VertexColumns<T>& range_columns,
+		const size_t first,
+		const size_t last
+		) const {
+	if(!valid_ || first > last || last > NumVertices())
+		return false;
+	if(ReadVerticesSpecialized(range_columns, first, last))
+		return true;
+
+	const Element& vertex = header_.elements[vertex_element_];
+	const bool swap = header_.format == Format::kBinaryBigEndian;
+	const uint8_t* const records = data_ + vertex_offset_ + first * vertex.record_size;
+	const size_t count = last - first;
+
+	const std::array<std::pair<T*, int>, 7> scalar_columns = {{
+		{range_columns.x, xyz_[0]},
+		{range_columns.y, xyz_[1]},
+		{range_columns.z, xyz_[2]},
+		{range_columns.nx, normal_[0]},
+		{range_columns.ny, normal_[1]},
+		{range_columns.nz, normal_[2]},
+		{range_columns.intensity, intensity_}
+	}};
+	for(const std::pair<T*, int>& column : scalar_columns) {
+		if(column.first == nullptr || column.second < 0)
+			continue;
+		const Property& property = vertex.properties[static_cast<size_t>(column.second)];
+		DecodeScalarColumn(property.type, swap, records + property.offset, vertex.record_size, count, column.first);
+	}
+
+	if(range_columns.rgb != nullptr && HasColors()) {
+		for(size_t channel = 0; channel < 3; ++channel)
+			DecodeColorColumn(vertex.properties[static_cast<size_t>(rgb_[channel])], swap, records, vertex.record_size, count, channel, range_columns.rgb);
+	}
+	return true;
+}
+
+template <typename T>
+bool PlyReader::ReadVerticesSpecialized(
+		const VertexColumns<T>& range_columns,
+		const size_t first,
+		const size_t last
+		) const {
+	if(!layout_.coordinates || range_columns.x == nullptr || range_columns.y == nullptr || range_columns.z == nullptr)
+		return false;
+
+	// requested properties that the file has must fit the layout, the others are skipped
+	const bool colors = range_columns.rgb != nullptr && HasColors();
+	const bool normals_requested = range_columns.nx != nullptr || range_columns.ny != nullptr || range_columns.nz != nullptr;
+	const bool normals = normals_requested && HasNormals();
+	const bool intensity = range_columns.intensity != nullptr && HasIntensities();
+	if((colors && !layout_.uchar_colors)
+		|| (normals && (!layout_.coordinate_normals || range_columns.nx == nullptr || range_columns.ny == nullptr || range_columns.nz == nullptr))
+		|| (intensity && !layout_.float_intensity))
+		return false;
+
+	const Element& vertex = header_.elements[vertex_element_];
+	const auto offset = [&](const int property) {
+		return property < 0 ? 0 : vertex.properties[static_cast<size_t>(property)].offset;
+	};
+	VertexOffsets offsets;
+	for(size_t k = 0; k < 3; ++k) {
+		offsets.xyz[k] = offset(xyz_[k]);
+		offsets.rgb[k] = offset(rgb_[k]);
+		offsets.normal[k] = offset(normal_[k]);
+	}
+	offsets.intensity = offset(intensity_);
+
+	const uint8_t* const records = data_ + vertex_offset_ + first * vertex.record_size;
+	const size_t count = last - first;
+	const auto decode = [&](auto coordinate, auto swap, auto with_colors, auto with_normals, auto intensity_scalar) {
+		DecodeVertexRecords<
+			T,
+			decltype(coordinate),
+			decltype(swap)::value,
+			decltype(with_colors)::value,
+			decltype(with_normals)::value,
+			decltype(intensity_scalar)
+			>(offsets, records, vertex.record_size, count, range_columns);
+	};
+	return DispatchFloatType(layout_.coordinate_type, [&](auto coordinate) {
+		DispatchFlag(header_.format == Format::kBinaryBigEndian, [&](auto swap) {
+			DispatchFlag(colors, [&](auto with_colors) {
+				DispatchFlag(normals, [&](auto with_normals) {
+					if(!intensity || !DispatchFloatType(layout_.intensity_type, [&](auto intensity_scalar) {
+							decode(coordinate, swap, with_colors, with_normals, intensity_scalar);
+						}))
+						decode(coordinate, swap, with_colors, with_normals, NoScalar());
+				});
+			});
+		});
+	});
+}
+
+template <typename T>
+bool PlyReader::ReadVertices(const VertexColumns<T>& columns) const {
+	if(!valid_)
+		return false;
+
+	const size_t num_vertices = NumVertices();
+	const size_t num_ranges = (num_vertices + kVerticesPerRange - 1) / kVerticesPerRange;
+	std::atomic<bool> ok{true};
+	#pragma omp parallel for schedule(static)
+	for(size_t r = 0; r < num_ranges; ++r) {
+		const size_t first = r * kVerticesPerRange;
+		if(!ReadVertices(columns, first, std::min(first + kVerticesPerRange, num_vertices)))
+			ok = false;
+	}
+	return ok;
+}
+
+bool PlyReader::ReadFaces(std::vector<std::array<size_t, 3>>* const triangles) const {
+	triangles->clear();
+	if(!valid_ || face_element_ < 0)
+		return valid_;
+
+	const Element& face = header_.elements[static_cast<size_t>(face_element_)];
+	const int indices = face.FindProperty({"vertex_indices", "vertex_index"});
+	size_t offset = 0;
+	if(indices < 0 || !ElementOffset(static_cast<size_t>(face_element_), &offset))
+		return false;
+
+	triangles->resize(face.count);
+	for(size_t i = 0; i < face.count; ++i) {
+		for(size_t p = 0; p < face.properties.size(); ++p) {
+			const Property& property = face.properties[p];
+			const size_t item_size = ScalarSize(property.type);
+			if(!property.is_list) {
+				offset += item_size;
+				continue;
+			}
+
+			const size_t count_size = ScalarSize(property.count_type);
+			if(offset + count_size > size_)
+				return false;
+			const size_t count = ReadIndex(property.count_type, offset);
+			offset += count_size;
+			if(count > (size_ - offset) / item_size)
+				return false;
+			if(static_cast<int>(p) == indices) {
+				if(count != 3)
+					return false;
+				for(size_t j = 0; j < 3; ++j)
+					(*triangles)[i][j] = ReadIndex(property.type, offset + j * item_size);
+			}
+			offset += count * item_size;
+		}
+		if(offset > size_)
+			return false;
+	}
+	return true;
+}
+
+bool PlyReader::ElementOffset(
+		const size_t element,
+		size_t* const offset
+		) const {
+	*offset = header_.data_offset;
+	for(size_t e = 0; e < element; ++e) {
+		const Element& preceding = header_.elements[e];
+		if(preceding.record_size > 0) {
+			if(preceding.count > (size_ - std::min(*offset, size_)) / preceding.record_size)
+				return false;
+			*offset += preceding.count * preceding.record_size;
+			continue;
+		}
+		for(size_t i = 0; i < preceding.count; ++i) {
+			const size_t record_size = RecordSize(preceding, *offset);
+			if(record_size == 0)
+				return false;
+			*offset += record_size;
+		}
+	}
+	return *offset <= size_;
+}
+
+size_t PlyReader::RecordSize(
+		const Element& element,
+		const size_t offset
+		) const {
+	size_t end = offset;
+	for(const Property& property : element.properties) {
+		if(property.is_list) {
+			if(end + ScalarSize(property.count_type) > size_)
+				return 0;
+			const size_t count = ReadIndex(property.count_type, end);
+			end += ScalarSize(property.count_type);
+			if(count > (size_ - end) / ScalarSize(property.type))
+				return 0;
+			end += count * ScalarSize(property.type);
+		} else {
+			end += ScalarSize(property.type);
+		}
+	}
+	return end > size_ ? 0 : end - offset;
+}
+
+size_t PlyReader::ReadIndex(
+		const ScalarType type,
+		const size_t offset
+		) const {
+	size_t value = 0;
+	const bool swap = header_.format == Format::kBinaryBigEndian;
+	DispatchScalarType(type, [&](auto scalar) {
+		using S = decltype(scalar);
+		value = static_cast<size_t>(swap ? Load<S, true>(data_ + offset) : Load<S, false>(data_ + offset));
+	});
+	return value;
+}
+
+template void DecodeScalarColumn<float>(const ScalarType, const bool, const uint8_t* const, const size_t, const size_t, float* const);
+template void DecodeScalarColumn<double>(const ScalarType, const bool, const uint8_t* const, const size_t, const size_t, double* const);
+template bool PlyReader::ReadVertices<float>(const VertexColumns<float>&, const size_t, const size_t) const;
+template bool PlyReader::ReadVertices<double>(const VertexColumns<double>&, const size_t, const size_t) const;
+template bool PlyReader::ReadVertexRange<float>(const VertexColumns<float>&, const size_t, const size_t) const;
+template bool PlyReader::ReadVertexRange<double>(const VertexColumns<double>&, const size_t, const size_t) const;
+template bool PlyReader::ReadVertices<float>(const VertexColumns<float>&) const;
+template bool PlyReader::ReadVertices<double>(const VertexColumns<double>&) const;
+
+} // namespace ply_reader
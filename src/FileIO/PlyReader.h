@@ -0,0 +1,270 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ply_reader {
+
+enum class Format {
+	kAscii,
+	kBinaryLittleEndian,
+	kBinaryBigEndian
+};
+
+enum class ScalarType {
+	kInt8,
+	kUint8,
+	kInt16,
+	kUint16,
+	kInt32,
+	kUint32,
+	kFloat32,
+	kFloat64
+};
+
+///
+/// Size of one scalar of the type in bytes.
+///
+size_t ScalarSize(const ScalarType type);
+
+///
+/// Parses the PLY type names, both the classic (uchar, float) and the sized (uint8, float32) ones.
+/// Returns false for unknown names.
+///
+bool ParseScalarType(
+	const std::string& name,
+	ScalarType* const type
+	);
+
+///
+/// A property of an element. List properties store the type of their count in count_type and of their items in type.
+/// offset is the byte offset of the property in the record, only meaningful for elements without lists.
+///
+struct Property {
+	std::string name;
+	ScalarType type = ScalarType::kFloat32;
+	bool is_list = false;
+	ScalarType count_type = ScalarType::kUint8;
+	size_t offset = 0;
+};
+
+///
+/// An element with its properties in file order.
+/// record_size is the size of one record in bytes, 0 if the element has list properties and variable sized records.
+///
+struct Element {
+	std::string name;
+	size_t count = 0;
+	std::vector<Property> properties;
+	size_t record_size = 0;
+
+	///
+	/// Index of the first property with one of the names, -1 if there is none.
+	///
+	int FindProperty(const std::vector<std::string>& names) const;
+};
+
+struct Header {
+	Format format = Format::kBinaryLittleEndian;
+	std::vector<Element> elements;
+	// byte offset of the first element in the file
+	size_t data_offset = 0;
+};
+
+///
+/// Parses the header at the start of data. Returns false if it is not a complete PLY header.
+///
+bool ParseHeader(
+	const uint8_t* const data,
+	const size_t size,
+	Header* const header
+	);
+
+///
+/// Decodes count scalars of the type, stride bytes apart, to T. Big endian scalars are swapped if swap is set.
+/// The type is dispatched once for the column, other binary point readers use this for their columns too.
+///
+template <typename T>
+void DecodeScalarColumn(
+	const ScalarType type,
+	const bool swap,
+	const uint8_t* const base,
+	const size_t stride,
+	const size_t count,
+	T* const destination
+	);
+
+///
+/// Caller provided destinations for the vertex properties, indexed by the vertex index.
+/// Null columns are not decoded. Columns whose property is missing in the file are left untouched.
+///
+template <typename T>
+struct VertexColumns {
+	T* x = nullptr;
+	T* y = nullptr;
+	T* z = nullptr;
+	std::array<uint8_t, 3>* rgb = nullptr;
+	T* nx = nullptr;
+	T* ny = nullptr;
+	T* nz = nullptr;
+	T* intensity = nullptr;
+};
+
+///
+/// Memory mapped reader for binary PLY files.
+/// The header describes the type and position of every property, so vertices are decoded straight from the mapped file
+/// into the columns with any property order and any scalar types. Properties that are not asked for are skipped.
+/// Big endian files are byte swapped while decoding. ASCII files are not supported by this reader.
+///
+class PlyReader {
+public:
+	explicit PlyReader(const std::string& ply_file);
+	~PlyReader();
+
+	PlyReader(const PlyReader&) = delete;
+	PlyReader& operator=(const PlyReader&) = delete;
+
+	///
+	/// Returns false if the file could not be mapped or is not a binary PLY file with a vertex element
+	/// that fits into the file.
+	///
+	bool IsOpen() const {
+		return valid_;
+	}
+
+	const Header& GetHeader() const {
+		return header_;
+	}
+
+	size_t NumVertices() const {
+		return valid_ ? header_.elements[vertex_element_].count : 0;
+	}
+
+	bool HasCoordinates() const {
+		return xyz_[0] >= 0 && xyz_[1] >= 0 && xyz_[2] >= 0;
+	}
+
+	bool HasColors() const {
+		return rgb_[0] >= 0 && rgb_[1] >= 0 && rgb_[2] >= 0;
+	}
+
+	bool HasNormals() const {
+		return normal_[0] >= 0 && normal_[1] >= 0 && normal_[2] >= 0;
+	}
+
+	bool HasIntensities() const {
+		return intensity_ >= 0;
+	}
+
+	bool HasFaces() const {
+		return face_element_ >= 0;
+	}
+
+	///
+	/// Decodes the vertices [first, last) into the columns. Independent ranges can be decoded concurrently.
+	/// Common layouts (float or double coordinates with optional uchar colors, normals of the coordinate type and a
+	/// floating point intensity, in any order and byte order) go through a decoder specialized for the layout,
+	/// everything else through per column decoding.
+	///
+	template <typename T>
+	bool ReadVertices(
+		const VertexColumns<T>& columns,
+		const size_t first,
+		const size_t last
+		) const;
+
+	///
+	/// Decodes the vertices [first, last) into the start of the columns, so a range can be streamed through
+	/// buffers that only hold last - first vertices.
+	///
+	template <typename T>
+	bool ReadVertexRange(
+		const VertexColumns<T>& range_columns,
+		const size_t first,
+		const size_t last
+		) const;
+
+	///
+	/// Decodes all vertices, OpenMP parallel over ranges of vertices.
+	///
+	template <typename T>
+	bool ReadVertices(const VertexColumns<T>& columns) const;
+
+	///
+	/// Reads the vertex indices of the face element. Returns false if a face is not a triangle.
+	///
+	bool ReadFaces(std::vector<std::array<size_t, 3>>* const triangles) const;
+
+private:
+	///
+	/// Byte offset of the element in the file, walks the records of preceding variable sized elements.
+	/// Returns false if the file ends before the element.
+	///
+	bool ElementOffset(
+		const size_t element,
+		size_t* const offset
+		) const;
+
+	///
+	/// Size of the variable sized record at offset, 0 if it exceeds the file.
+	///
+	size_t RecordSize(
+		const Element& element,
+		const size_t offset
+		) const;
+
+	///
+	/// Reads one scalar of the type at offset as size_t, used for list counts and indices.
+	///
+	size_t ReadIndex(
+		const ScalarType type,
+		const size_t offset
+		) const;
+
+	///
+	/// Decodes the range into the start of the columns with the decoder specialized for the vertex layout.
+	/// Returns false without touching the columns if the layout or the requested columns have no specialized decoder.
+	///
+	template <typename T>
+	bool ReadVerticesSpecialized(
+		const VertexColumns<T>& range_columns,
+		const size_t first,
+		const size_t last
+		) const;
+
+	int fd_ = -1;
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+	bool valid_ = false;
+	Header header_;
+
+	size_t vertex_element_ = 0;
+	size_t vertex_offset_ = 0;
+	int face_element_ = -1;
+
+	// property indices of the vertex element, -1 if missing
+	std::array<int, 3> xyz_ = {{-1, -1, -1}};
+	std::array<int, 3> rgb_ = {{-1, -1, -1}};
+	std::array<int, 3> normal_ = {{-1, -1, -1}};
+	int intensity_ = -1;
+
+	///
+	/// The vertex layout as the specialized decoders are keyed on it, worked out once from the header.
+	///
+	struct SpecializedLayout {
+		// the coordinates exist and share a floating point type
+		bool coordinates = false;
+		ScalarType coordinate_type = ScalarType::kFloat32;
+		bool uchar_colors = false;
+		// the normals have the coordinate type
+		bool coordinate_normals = false;
+		bool float_intensity = false;
+		ScalarType intensity_type = ScalarType::kFloat32;
+	};
+	SpecializedLayout layout_;
+};
+
+} // namespace ply_reader
@@ -0,0 +1,192 @@
+#include "PlyWriter.h"
+
+#include <algorithm>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+template <typename S>
+void Store(const S value, uint8_t** const out) {
+	std::memcpy(*out, &value, sizeof(S));
+	*out += sizeof(S);
+}
+
+template <typename T>
+std::string PlyHeader(const ply_writer::PlyLayout& layout) {
+	const std::string precision_type = (sizeof(T) == sizeof(float) ? "float" : "double");
+
+	std::ostringstream header;
+	header << "ply" << std::endl;
+	header << "format binary_little_endian 1.0" << std::endl;
+	header << "element vertex " << layout.num_vertices << std::endl;
+	header << "property " + precision_type + " x" << std::endl;
+	header << "property " + precision_type + " y" << std::endl;
+	header << "property " + precision_type + " z" << std::endl;
+	if(layout.normals) {
+		header << "property " + precision_type + " nx" << std::endl;
+		header << "property " + precision_type + " ny" << std::endl;
+		header << "property " + precision_type + " nz" << std::endl;
+	}
+	if(layout.colors) {
+		header << "property uchar red" << std::endl;
+		header << "property uchar green" << std::endl;
+		header << "property uchar blue" << std::endl;
+		header << "property uchar alpha" << std::endl;
+	}
+	if(layout.intensities) {
+		header << "property " + precision_type + " intensity_value" << std::endl;
+	}
+	if(layout.triangles) {
+		header << "element face " << layout.num_triangles << std::endl;
+		header << "property list uchar int vertex_indices" << std::endl;
+	}
+	header << "end_header" << std::endl;
+	return header.str();
+}
+
+} // namespace
+
+namespace ply_writer {
+
+template <typename T>
+PlyWriter<T>::PlyWriter(
+		const std::string& file,
+		const PlyLayout& layout
+		) : layout_(layout) {
+	fd_ = open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	vertex_size_ = 3 * sizeof(T);
+	if(layout_.normals) vertex_size_ += 3 * sizeof(T);
+	if(layout_.colors) vertex_size_ += 4 * sizeof(uint8_t);
+	if(layout_.intensities) vertex_size_ += sizeof(T);
+
+	const std::string header = PlyHeader<T>(layout_);
+	vertices_offset_ = header.size();
+	triangles_offset_ = vertices_offset_ + layout_.num_vertices * vertex_size_;
+	WriteAt(0, reinterpret_cast<const uint8_t*>(header.data()), header.size());
+}
+
+template <typename T>
+PlyWriter<T>::~PlyWriter() {
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+template <typename T>
+bool PlyWriter<T>::WriteVertices(
+		const size_t first,
+		const geometry::PointCloud<T>& points
+		) {
+	if((layout_.normals && !points.HasNormals()) || (layout_.colors && !points.HasColors())
+		|| (layout_.intensities && !points.HasIntensities()) || first + points.Size() > layout_.num_vertices) {
+		good_ = false;
+		return false;
+	}
+
+	const size_t num_batches = (points.Size() + kVerticesPerBatch - 1) / kVerticesPerBatch;
+	#pragma omp parallel if(num_batches > 1)
+	{
+		std::vector<uint8_t> data(std::min(points.Size(), kVerticesPerBatch) * vertex_size_);
+		#pragma omp for schedule(static)
+		for(size_t b = 0; b < num_batches; ++b) {
+			const size_t begin = b * kVerticesPerBatch;
+			const size_t end = std::min(begin + kVerticesPerBatch, points.Size());
+			uint8_t* out = data.data();
+			for(size_t i = begin; i < end; ++i) {
+				Store<T>(points.X()[i], &out);
+				Store<T>(points.Y()[i], &out);
+				Store<T>(points.Z()[i], &out);
+				if(layout_.normals) {
+					Store<T>(points.Nx()[i], &out);
+					Store<T>(points.Ny()[i], &out);
+					Store<T>(points.Nz()[i], &out);
+				}
+				if(layout_.colors) {
+					for(size_t j = 0; j < 3; ++j)
+						Store<uint8_t>(points.Colors()[i][j], &out);
+					Store<uint8_t>(255, &out);
+				}
+				if(layout_.intensities)
+					Store<T>(points.Intensities()[i], &out);
+			}
+			WriteAt(vertices_offset_ + (first + begin) * vertex_size_, data.data(), (end - begin) * vertex_size_);
+		}
+	}
+	num_written_vertices_ += points.Size();
+	return Good();
+}
+
+template <typename T>
+bool PlyWriter<T>::AppendVertices(const geometry::PointCloud<T>& points) {
+	const size_t first = next_vertex_;
+	next_vertex_ += points.Size();
+	return WriteVertices(first, points);
+}
+
+template <typename T>
+bool PlyWriter<T>::WriteTriangles(
+		const size_t first,
+		const std::vector<std::array<size_t, 3>>& triangles
+		) {
+	if(!layout_.triangles || first + triangles.size() > layout_.num_triangles) {
+		good_ = false;
+		return false;
+	}
+
+	const size_t num_batches = (triangles.size() + kVerticesPerBatch - 1) / kVerticesPerBatch;
+	#pragma omp parallel if(num_batches > 1)
+	{
+		std::vector<uint8_t> data(std::min(triangles.size(), kVerticesPerBatch) * kTriangleSize);
+		#pragma omp for schedule(static)
+		for(size_t b = 0; b < num_batches; ++b) {
+			const size_t begin = b * kVerticesPerBatch;
+			const size_t end = std::min(begin + kVerticesPerBatch, triangles.size());
+			uint8_t* out = data.data();
+			for(size_t i = begin; i < end; ++i) {
+				Store<uint8_t>(3, &out);
+				for(size_t j = 0; j < 3; ++j)
+					Store<int32_t>(static_cast<int32_t>(triangles[i][j]), &out);
+			}
+			WriteAt(triangles_offset_ + (first + begin) * kTriangleSize, data.data(), (end - begin) * kTriangleSize);
+		}
+	}
+	num_written_triangles_ += triangles.size();
+	return Good();
+}
+
+template <typename T>
+bool PlyWriter<T>::Finish() {
+	if(num_written_vertices_ != layout_.num_vertices || num_written_triangles_ != layout_.num_triangles)
+		good_ = false;
+	return Good();
+}
+
+template <typename T>
+bool PlyWriter<T>::WriteAt(
+		size_t offset,
+		const uint8_t* data,
+		size_t n
+		) {
+	while(fd_ >= 0 && good_ && n > 0) {
+		const ssize_t ret = pwrite(fd_, data, n, static_cast<off_t>(offset));
+		if(ret < 0 && errno == EINTR)
+			continue;
+		if(ret <= 0) {
+			good_ = false;
+			break;
+		}
+		data += ret;
+		offset += static_cast<size_t>(ret);
+		n -= static_cast<size_t>(ret);
+	}
+	return Good();
+}
+
+template class PlyWriter<float>;
+template class PlyWriter<double>;
+
+} // namespace ply_writer
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <Geometry/PointCloud.h>
+
+namespace ply_writer {
+
+///
+/// What a written file holds. Vertices are laid out as xyz [normal] [rgba] [intensity], faces as triangles.
+///
+struct PlyLayout {
+	size_t num_vertices = 0;
+	bool normals = false;
+	bool colors = false;
+	bool intensities = false;
+	// a face element is declared even when it is empty
+	bool triangles = false;
+	size_t num_triangles = 0;
+};
+
+///
+/// Streaming writer for binary little endian PLY files.
+/// The header is written when the file is opened, after that the position of every vertex and triangle in the file is
+/// known, so batches are encoded independently and written at their offset with pwrite. Batches can be written in any
+/// order and by several threads at once, and only the batches being encoded are held in memory.
+///
+template <typename T>
+class PlyWriter {
+public:
+	PlyWriter(
+		const std::string& file,
+		const PlyLayout& layout
+		);
+	~PlyWriter();
+
+	PlyWriter(const PlyWriter&) = delete;
+	PlyWriter& operator=(const PlyWriter&) = delete;
+
+	///
+	/// Returns false if the file could not be opened or a write failed.
+	///
+	bool Good() const {
+		return fd_ >= 0 && good_;
+	}
+
+	///
+	/// Writes the points as the vertices starting at first. The points need the columns of the layout.
+	/// Batches larger than kVerticesPerBatch are encoded OpenMP parallel. Safe to call from multiple threads
+	/// for disjoint ranges of vertices.
+	///
+	bool WriteVertices(
+		const size_t first,
+		const geometry::PointCloud<T>& points
+		);
+
+	///
+	/// Writes the points after the vertices appended so far, for streaming batches in order from one thread.
+	///
+	bool AppendVertices(const geometry::PointCloud<T>& points);
+
+	///
+	/// Writes the triangles as the faces starting at first. Safe to call from multiple threads for disjoint ranges.
+	///
+	bool WriteTriangles(
+		const size_t first,
+		const std::vector<std::array<size_t, 3>>& triangles
+		);
+
+	///
+	/// Fails if a write failed or not all vertices and triangles of the layout were written.
+	///
+	bool Finish();
+
+	// vertices and triangles are encoded in batches of this many
+	static constexpr size_t kVerticesPerBatch = 65536;
+
+private:
+	///
+	/// Positional write of all n bytes.
+	///
+	bool WriteAt(
+		size_t offset,
+		const uint8_t* data,
+		size_t n
+		);
+
+	static constexpr size_t kTriangleSize = sizeof(uint8_t) + 3 * sizeof(int32_t);
+
+	int fd_ = -1;
+	std::atomic<bool> good_{true};
+	const PlyLayout layout_;
+	size_t vertex_size_ = 0;
+	size_t vertices_offset_ = 0;
+	size_t triangles_offset_ = 0;
+	size_t next_vertex_ = 0;
+	std::atomic<size_t> num_written_vertices_{0};
+	std::atomic<size_t> num_written_triangles_{0};
+};
+
+} // namespace ply_writer
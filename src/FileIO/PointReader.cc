@@ -0,0 +1,152 @@
+#include "PointReader.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include <FileIO/PlyReader.h>
+#include <FileIO/LasReader.h>
+#include <FileIO/PcdReader.h>
+#include <FileIO/TextPointReader.h>
+
+namespace {
+
+// vertices of binary PLY files are read in ranges of this many
+constexpr size_t kVerticesPerRange = 65536;
+
+///
+/// Binary PLY files, ranges of vertices are decoded straight from the mapped file.
+///
+template <typename T>
+class BinaryPlyReader : public point_reader::PointReader<T> {
+public:
+	explicit BinaryPlyReader(const std::string& file) : reader_(file) {
+	}
+
+	bool IsOpen() const override final {
+		return reader_.IsOpen() && reader_.HasCoordinates();
+	}
+
+	bool HasColors() const override final {
+		return reader_.HasColors();
+	}
+
+	bool HasNormals() const override final {
+		return reader_.HasNormals();
+	}
+
+	bool HasIntensities() const override final {
+		return reader_.HasIntensities();
+	}
+
+	size_t NumRanges() const override final {
+		return (reader_.NumVertices() + kVerticesPerRange - 1) / kVerticesPerRange;
+	}
+
+	bool ReadRange(
+			const size_t range,
+			geometry::PointCloud<T>* const points
+			) const override final {
+		const size_t first = range * kVerticesPerRange;
+		const size_t last = std::min(first + kVerticesPerRange, reader_.NumVertices());
+		if(first >= last)
+			return false;
+
+		if(HasColors() && !points->HasColors())
+			points->EnableColors();
+		if(HasNormals() && !points->HasNormals())
+			points->EnableNormals();
+		if(HasIntensities() && !points->HasIntensities())
+			points->EnableIntensities();
+		points->Resize(last - first);
+
+		ply_reader::VertexColumns<T> columns;
+		columns.x = points->X().data();
+		columns.y = points->Y().data();
+		columns.z = points->Z().data();
+		columns.rgb = points->HasColors() ? points->Colors().data() : nullptr;
+		columns.nx = points->HasNormals() ? points->Nx().data() : nullptr;
+		columns.ny = points->HasNormals() ? points->Ny().data() : nullptr;
+		columns.nz = points->HasNormals() ? points->Nz().data() : nullptr;
+		columns.intensity = points->HasIntensities() ? points->Intensities().data() : nullptr;
+		return reader_.ReadVertexRange(columns, first, last);
+	}
+
+private:
+	const ply_reader::PlyReader reader_;
+};
+
+} // namespace
+
+namespace point_reader {
+
+template <typename T>
+bool PointReader<T>::ReadAll(geometry::PointCloud<T>* const cloud) const {
+	const size_t num_ranges = NumRanges();
+	std::vector<geometry::PointCloud<T>> range_clouds(num_ranges);
+	std::atomic<bool> ok{IsOpen()};
+	#pragma omp parallel for schedule(dynamic)
+	for(size_t r = 0; r < num_ranges; ++r)
+		if(!ReadRange(r, &range_clouds[r]))
+			ok = false;
+	if(!ok)
+		return false;
+
+	std::vector<size_t> range_offsets(num_ranges + 1, 0);
+	for(size_t r = 0; r < num_ranges; ++r)
+		range_offsets[r + 1] = range_offsets[r] + range_clouds[r].Size();
+
+	geometry::PointCloud<T> all;
+	if(HasColors())
+		all.EnableColors();
+	if(HasNormals())
+		all.EnableNormals();
+	if(HasIntensities())
+		all.EnableIntensities();
+	all.Resize(range_offsets.back());
+
+	#pragma omp parallel for schedule(static)
+	for(size_t r = 0; r < num_ranges; ++r) {
+		const geometry::PointCloud<T>& range = range_clouds[r];
+		const size_t offset = range_offsets[r];
+		std::copy(range.X().begin(), range.X().end(), all.X().begin() + static_cast<std::ptrdiff_t>(offset));
+		std::copy(range.Y().begin(), range.Y().end(), all.Y().begin() + static_cast<std::ptrdiff_t>(offset));
+		std::copy(range.Z().begin(), range.Z().end(), all.Z().begin() + static_cast<std::ptrdiff_t>(offset));
+		if(all.HasColors())
+			std::copy(range.Colors().begin(), range.Colors().end(), all.Colors().begin() + static_cast<std::ptrdiff_t>(offset));
+		if(all.HasNormals()) {
+			std::copy(range.Nx().begin(), range.Nx().end(), all.Nx().begin() + static_cast<std::ptrdiff_t>(offset));
+			std::copy(range.Ny().begin(), range.Ny().end(), all.Ny().begin() + static_cast<std::ptrdiff_t>(offset));
+			std::copy(range.Nz().begin(), range.Nz().end(), all.Nz().begin() + static_cast<std::ptrdiff_t>(offset));
+		}
+		if(all.HasIntensities())
+			std::copy(range.Intensities().begin(), range.Intensities().end(), all.Intensities().begin() + static_cast<std::ptrdiff_t>(offset));
+	}
+
+	*cloud = std::move(all);
+	return true;
+}
+
+template <typename T>
+std::unique_ptr<PointReader<T>> OpenPointReader(const std::string& file) {
+	std::unique_ptr<PointReader<T>> reader(new LasReader<T>(file));
+	if(reader->IsOpen())
+		return reader;
+	// PCD headers would otherwise be taken for a header line of a text file
+	std::unique_ptr<PcdReader<T>> pcd_reader(new PcdReader<T>(file));
+	if(pcd_reader->IsPcd())
+		return pcd_reader->IsOpen() ? std::move(pcd_reader) : nullptr;
+	reader.reset(new BinaryPlyReader<T>(file));
+	if(reader->IsOpen())
+		return reader;
+	reader.reset(new TextPointReader<T>(file));
+	if(reader->IsOpen())
+		return reader;
+	return nullptr;
+}
+
+template class PointReader<float>;
+template class PointReader<double>;
+template std::unique_ptr<PointReader<float>> OpenPointReader<float>(const std::string&);
+template std::unique_ptr<PointReader<double>> OpenPointReader<double>(const std::string&);
+
+} // namespace point_reader
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+#include <Geometry/PointCloud.h>
+
+namespace point_reader {
+
+///
+/// Point file split into ranges that are read independently, so the ranges of a file can be read concurrently
+/// and streamed through buffers of one range.
+///
+template <typename T>
+class PointReader {
+public:
+	virtual ~PointReader() { };
+
+	virtual bool IsOpen() const = 0;
+
+	virtual bool HasColors() const = 0;
+
+	virtual bool HasNormals() const = 0;
+
+	virtual bool HasIntensities() const = 0;
+
+	virtual size_t NumRanges() const = 0;
+
+	///
+	/// Replaces the points with the points of the range. Enables the optional columns the file has.
+	///
+	virtual bool ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const = 0;
+
+	///
+	/// Reads all ranges, OpenMP parallel, and concatenates them in file order.
+	///
+	bool ReadAll(geometry::PointCloud<T>* const cloud) const;
+};
+
+///
+/// Opens a LAS file, a binary PCD file, a binary PLY file, an ASCII PLY file or a text file with a point per line (XYZ, CSV, PTS).
+/// Returns nullptr if none of the readers can open the file.
+///
+template <typename T>
+std::unique_ptr<PointReader<T>> OpenPointReader(const std::string& file);
+
+} // namespace point_reader
@@ -0,0 +1,160 @@
+#include "PointRecords.h"
+
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace point_records {
+
+namespace {
+
+// the vector loops load 16 bytes per record, one byte beyond the 15 byte record
+constexpr size_t kRecordSize = sizeof(XyzRgb);
+
+#if defined(__SSSE3__)
+///
+/// xyz1 of a record loaded into the low 15 bytes, w is set by or-ing 1.0f into the zeroed last lane.
+///
+inline __m128i ShuffleXyz1(const __m128i record) {
+	const __m128i xyz_mask = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1, -1, -1);
+	const __m128i w_one = _mm_castps_si128(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+	return _mm_or_si128(_mm_shuffle_epi8(record, xyz_mask), w_one);
+}
+#endif
+
+} // namespace
+
+void DecodeXyzRgbScalar(
+		const uint8_t* const records,
+		const size_t num_records,
+		float* const xyz1,
+		const size_t xyz1_stride,
+		uint8_t* const rgba,
+		const size_t rgba_stride,
+		const uint8_t alpha
+		) {
+	uint8_t* const xyz1_bytes = reinterpret_cast<uint8_t*>(xyz1);
+	for(size_t i = 0; i < num_records; ++i) {
+		const uint8_t* const record = records + i * kRecordSize;
+		float* const out_xyz1 = reinterpret_cast<float*>(xyz1_bytes + i * xyz1_stride);
+		std::memcpy(out_xyz1, record, 3 * sizeof(float));
+		out_xyz1[3] = 1.0f;
+		uint8_t* const out_rgba = rgba + i * rgba_stride;
+		std::memcpy(out_rgba, record + 3 * sizeof(float), 3 * sizeof(uint8_t));
+		out_rgba[3] = alpha;
+	}
+}
+
+void DecodeXyzRgb(
+		const uint8_t* const records,
+		const size_t num_records,
+		float* const xyz1,
+		const size_t xyz1_stride,
+		uint8_t* const rgba,
+		const size_t rgba_stride,
+		const uint8_t alpha
+		) {
+	size_t i = 0;
+	uint8_t* const xyz1_bytes = reinterpret_cast<uint8_t*>(xyz1);
+
+#if defined(__AVX2__)
+	// 8 records per iteration into contiguous rgba. register j holds record j in the low and record j + 4 in the high lane,
+	// so the shuffled colours of the four registers or together into the rgba of records 0-3 and 4-7
+	if(rgba_stride == 4) {
+		const __m256i xyz_mask = _mm256_setr_epi8(
+			0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1, -1, -1,
+			0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, -1, -1, -1, -1);
+		const __m256i w_one = _mm256_castps_si256(_mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f));
+		const __m256i rgb_masks[4] = {
+			_mm256_setr_epi8(
+				12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+			_mm256_setr_epi8(
+				-1, -1, -1, -1, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				-1, -1, -1, -1, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+			_mm256_setr_epi8(
+				-1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, -1, -1, -1, -1, -1,
+				-1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, -1, -1, -1, -1, -1),
+			_mm256_setr_epi8(
+				-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, -1,
+				-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, -1)
+		};
+		const __m256i alpha_bytes = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(alpha) << 24));
+
+		for(; i + 9 <= num_records; i += 8) {
+			const uint8_t* const group = records + i * kRecordSize;
+			__m256i rgba_out = alpha_bytes;
+			for(size_t j = 0; j < 4; ++j) {
+				const __m256i pair = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + j * kRecordSize))),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(group + (j + 4) * kRecordSize)),
+					1);
+				const __m256i xyz1_pair = _mm256_or_si256(_mm256_shuffle_epi8(pair, xyz_mask), w_one);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(xyz1_bytes + (i + j) * xyz1_stride), _mm256_castsi256_si128(xyz1_pair));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(xyz1_bytes + (i + j + 4) * xyz1_stride), _mm256_extracti128_si256(xyz1_pair, 1));
+				rgba_out = _mm256_or_si256(rgba_out, _mm256_shuffle_epi8(pair, rgb_masks[j]));
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i * 4), rgba_out);
+		}
+	}
+#endif
+
+#if defined(__SSSE3__)
+	// one record per iteration for any output layout
+	{
+		const __m128i rgb_mask = _mm_setr_epi8(12, 13, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		const __m128i alpha_byte = _mm_cvtsi32_si128(static_cast<int>(static_cast<uint32_t>(alpha) << 24));
+		for(; i + 2 <= num_records; ++i) {
+			const __m128i record = _mm_loadu_si128(reinterpret_cast<const __m128i*>(records + i * kRecordSize));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(xyz1_bytes + i * xyz1_stride), ShuffleXyz1(record));
+			const uint32_t rgba_value = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_or_si128(_mm_shuffle_epi8(record, rgb_mask), alpha_byte)));
+			std::memcpy(rgba + i * rgba_stride, &rgba_value, sizeof(uint32_t));
+		}
+	}
+#endif
+
+	DecodeXyzRgbScalar(
+		records + i * kRecordSize,
+		num_records - i,
+		reinterpret_cast<float*>(xyz1_bytes + i * xyz1_stride),
+		xyz1_stride,
+		rgba + i * rgba_stride,
+		rgba_stride,
+		alpha
+		);
+}
+
+void DecodeXyzRgba(
+		const uint8_t* const records,
+		const size_t num_records,
+		float* const xyz1,
+		const size_t xyz1_stride,
+		uint8_t* const rgba,
+		const size_t rgba_stride
+		) {
+	size_t i = 0;
+	uint8_t* const xyz1_bytes = reinterpret_cast<uint8_t*>(xyz1);
+
+#if defined(__SSE2__)
+	// the rgba lane of the record is replaced by 1.0f for xyz1 and stored on its own
+	const __m128i xyz_bits = _mm_setr_epi32(-1, -1, -1, 0);
+	const __m128i w_one = _mm_castps_si128(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+	for(; i < num_records; ++i) {
+		const __m128i record = _mm_loadu_si128(reinterpret_cast<const __m128i*>(records + i * sizeof(XyzRgba)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(xyz1_bytes + i * xyz1_stride), _mm_or_si128(_mm_and_si128(record, xyz_bits), w_one));
+		const uint32_t rgba_value = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(record, 12)));
+		std::memcpy(rgba + i * rgba_stride, &rgba_value, sizeof(uint32_t));
+	}
+#endif
+
+	for(; i < num_records; ++i) {
+		const uint8_t* const record = records + i * sizeof(XyzRgba);
+		float* const out_xyz1 = reinterpret_cast<float*>(xyz1_bytes + i * xyz1_stride);
+		std::memcpy(out_xyz1, record, 3 * sizeof(float));
+		out_xyz1[3] = 1.0f;
+		std::memcpy(rgba + i * rgba_stride, record + 3 * sizeof(float), 4 * sizeof(uint8_t));
+	}
+}
+
+} // namespace point_records
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace point_records {
+
+///
+/// On-disk record of the octree blocks with the float encoding.
+/// 3 floats for xyz followed by 3 bytes for rgb, 15 bytes without padding.
+///
+#pragma pack(push, 1)
+struct XyzRgb {
+	std::array<float, 3> xyz;
+	std::array<uint8_t, 3> rgb;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(XyzRgb) == 3 * sizeof(float) + 3 * sizeof(uint8_t), "XyzRgb records must be packed");
+static_assert(std::is_trivially_copyable<XyzRgb>::value, "XyzRgb records are copied as raw bytes");
+
+///
+/// Quantized record, 9 bytes.
+/// xyz are fixed-point offsets from the min corner of the level 0 cell of the block, 0 and 65535 are the cell bounds.
+///
+#pragma pack(push, 1)
+struct XyzRgbQuantized {
+	std::array<uint16_t, 3> xyz;
+	std::array<uint8_t, 3> rgb;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(XyzRgbQuantized) == 3 * sizeof(uint16_t) + 3 * sizeof(uint8_t), "XyzRgbQuantized records must be packed");
+static_assert(std::is_trivially_copyable<XyzRgbQuantized>::value, "XyzRgbQuantized records are copied as raw bytes");
+
+///
+/// Aligned record of the cache chunks and optionally the octree blocks, 16 bytes.
+/// 3 floats for xyz followed by rgba bytes, the interleaved vertex layout of the viewer,
+/// so a payload can go to the gpu as it is and a record is one aligned 128 bit load.
+///
+struct alignas(16) XyzRgba {
+	std::array<float, 3> xyz;
+	std::array<uint8_t, 4> rgba;
+};
+
+static_assert(sizeof(XyzRgba) == 16, "XyzRgba records must not be padded");
+static_assert(alignof(XyzRgba) == 16, "XyzRgba records must be 16 byte aligned");
+static_assert(std::is_trivially_copyable<XyzRgba>::value, "XyzRgba records are copied as raw bytes");
+
+///
+/// Encoding of a block payload, stored per block in the index of the file.
+///
+enum class Encoding : uint64_t {
+	kXyzRgb = 0,
+	kXyzRgbQuantized = 1,
+	kXyzRgba = 2
+};
+
+///
+/// Size of one record of the encoding in bytes.
+///
+inline size_t RecordSize(const Encoding encoding) {
+	switch(encoding) {
+	case Encoding::kXyzRgbQuantized:
+		return sizeof(XyzRgbQuantized);
+	case Encoding::kXyzRgba:
+		return sizeof(XyzRgba);
+	default:
+		return sizeof(XyzRgb);
+	}
+}
+
+///
+/// Largest fixed-point value, maps to the far bound of the cell.
+///
+constexpr float kQuantizationSteps = 65535.0f;
+
+///
+/// Quantizes a point of the cell with the given min corner and edge length. Points outside are clamped to the cell.
+///
+inline XyzRgbQuantized Quantize(
+	const XyzRgb& record,
+	const std::array<float, 3>& cell_origin,
+	const float cell_size
+	) {
+	XyzRgbQuantized quantized;
+	for(size_t i = 0; i < 3; ++i) {
+		const float normalized = (record.xyz[i] - cell_origin[i]) / cell_size;
+		quantized.xyz[i] = static_cast<uint16_t>(std::lround(std::min(std::max(normalized, 0.0f), 1.0f) * kQuantizationSteps));
+	}
+	quantized.rgb = record.rgb;
+	return quantized;
+}
+
+///
+/// Inverse of Quantize up to cell_size / 65535.
+///
+inline XyzRgb Dequantize(
+	const XyzRgbQuantized& quantized,
+	const std::array<float, 3>& cell_origin,
+	const float cell_size
+	) {
+	XyzRgb record;
+	for(size_t i = 0; i < 3; ++i)
+		record.xyz[i] = cell_origin[i] + static_cast<float>(quantized.xyz[i]) * (cell_size / kQuantizationSteps);
+	record.rgb = quantized.rgb;
+	return record;
+}
+
+///
+/// Unpacks num_records XyzRgb records from a raw byte buffer in one pass.
+/// Writes xyz1 as 4 floats with w = 1 every xyz1_stride bytes and rgba as 4 bytes with the given alpha every rgba_stride bytes,
+/// so the output can be separate gpu-ready arrays or the fields of an array of structs.
+/// Uses SSSE3 or AVX2 shuffles when compiled for them and a scalar loop otherwise.
+///
+void DecodeXyzRgb(
+	const uint8_t* const records,
+	const size_t num_records,
+	float* const xyz1,
+	const size_t xyz1_stride,
+	uint8_t* const rgba,
+	const size_t rgba_stride,
+	const uint8_t alpha = 255
+	);
+
+///
+/// Scalar version of DecodeXyzRgb, used for the records the vector loops do not cover.
+///
+void DecodeXyzRgbScalar(
+	const uint8_t* const records,
+	const size_t num_records,
+	float* const xyz1,
+	const size_t xyz1_stride,
+	uint8_t* const rgba,
+	const size_t rgba_stride,
+	const uint8_t alpha = 255
+	);
+
+///
+/// Unpacks num_records XyzRgba records into xyz1 floats with w = 1 and rgba bytes, with the strides of DecodeXyzRgb.
+/// One 128 bit load per record, the records do not have to be aligned.
+///
+void DecodeXyzRgba(
+	const uint8_t* const records,
+	const size_t num_records,
+	float* const xyz1,
+	const size_t xyz1_stride,
+	uint8_t* const rgba,
+	const size_t rgba_stride
+	);
+
+} // namespace point_records
@@ -0,0 +1,378 @@
+#include "TextPointReader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+// point lines are split into ranges of about this many bytes
+constexpr size_t kBytesPerRange = 4 << 20;
+
+// number of lines searched for the header line or the first point line of a text file
+constexpr size_t kMaxHeaderLines = 64;
+
+inline bool IsSeparator(const char c) {
+	return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r' || c == '\n';
+}
+
+inline const char* SkipSeparators(const char* p, const char* const end) {
+	while(p < end && IsSeparator(*p))
+		++p;
+	return p;
+}
+
+inline const char* SkipField(const char* p, const char* const end) {
+	while(p < end && !IsSeparator(*p))
+		++p;
+	return p;
+}
+
+///
+/// Parses the number at p and moves p behind it. Fails unless the whole field is the number.
+///
+template <typename S>
+inline bool ParseField(const char*& p, const char* const end, S* const value) {
+	if(p < end && *p == '+')
+		++p;
+	const std::from_chars_result result = std::from_chars(p, end, *value);
+	if(result.ec != std::errc())
+		return false;
+	p = result.ptr;
+	return p == end || IsSeparator(*p);
+}
+
+///
+/// Splits the line into its fields.
+///
+std::vector<std::string> SplitFields(const char* p, const char* const end) {
+	std::vector<std::string> fields;
+	for(p = SkipSeparators(p, end); p < end; p = SkipSeparators(p, end)) {
+		const char* const field_end = SkipField(p, end);
+		fields.emplace_back(p, field_end);
+		p = field_end;
+	}
+	return fields;
+}
+
+bool IsNumber(const std::string& field) {
+	const char* p = field.data();
+	double value;
+	return ParseField(p, field.data() + field.size(), &value) && p == field.data() + field.size();
+}
+
+///
+/// Colour channel from a parsed value, like the binary reader: floating point colours are in [0, 1],
+/// 16 bit colours use the upper byte.
+///
+template <typename T>
+uint8_t ColorChannel(const T value, const ply_reader::ScalarType type) {
+	if(type == ply_reader::ScalarType::kFloat32 || type == ply_reader::ScalarType::kFloat64)
+		return static_cast<uint8_t>(std::lround(std::min(std::max(static_cast<double>(value), 0.0), 1.0) * 255.0));
+	if(type == ply_reader::ScalarType::kUint16)
+		return static_cast<uint8_t>(static_cast<uint16_t>(std::min(std::max(static_cast<double>(value), 0.0), 65535.0)) >> 8);
+	return static_cast<uint8_t>(std::min(std::max(static_cast<double>(value), 0.0), 255.0));
+}
+
+} // namespace
+
+namespace point_reader {
+
+template <typename T>
+TextPointReader<T>::TextPointReader(const std::string& file) {
+	fields_.fill(-1);
+
+	fd_ = open(file.c_str(), O_RDONLY);
+	if(fd_ < 0)
+		return;
+
+	struct stat file_stat;
+	if(fstat(fd_, &file_stat) != 0 || file_stat.st_size <= 0)
+		return;
+	void* const mapped = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, fd_, 0);
+	if(mapped == MAP_FAILED)
+		return;
+	data_ = static_cast<const char*>(mapped);
+	size_ = static_cast<size_t>(file_stat.st_size);
+	madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+
+	is_ply_ = size_ >= 4 && std::memcmp(data_, "ply", 3) == 0 && (data_[3] == '\n' || data_[3] == '\r');
+	valid_ = (is_ply_ ? OpenPly() : OpenXyz()) && fields_[kX] >= 0 && fields_[kY] >= 0 && fields_[kZ] >= 0;
+}
+
+template <typename T>
+TextPointReader<T>::~TextPointReader() {
+	if(data_ != nullptr)
+		munmap(const_cast<char*>(data_), size_);
+	if(fd_ >= 0)
+		close(fd_);
+}
+
+template <typename T>
+bool TextPointReader<T>::ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const {
+	if(!valid_ || range >= ranges_.size())
+		return false;
+
+	if(HasColors() && !points->HasColors())
+		points->EnableColors();
+	if(HasNormals() && !points->HasNormals())
+		points->EnableNormals();
+	if(HasIntensities() && !points->HasIntensities())
+		points->EnableIntensities();
+	points->Resize(0);
+
+	std::array<T, kNumSlots> values;
+	const char* p = data_ + ranges_[range].first;
+	const char* const end = data_ + ranges_[range].second;
+	while(p < end) {
+		const void* const newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+		const char* const line_end = newline != nullptr ? static_cast<const char*>(newline) : end;
+		if(ParseLine(p, line_end, &values)) {
+			points->X().push_back(values[kX]);
+			points->Y().push_back(values[kY]);
+			points->Z().push_back(values[kZ]);
+			if(points->HasColors()) {
+				points->Colors().push_back({{
+					ColorChannel(values[kRed], color_type_),
+					ColorChannel(values[kGreen], color_type_),
+					ColorChannel(values[kBlue], color_type_)
+				}});
+			}
+			if(points->HasNormals()) {
+				points->Nx().push_back(values[kNx]);
+				points->Ny().push_back(values[kNy]);
+				points->Nz().push_back(values[kNz]);
+			}
+			if(points->HasIntensities())
+				points->Intensities().push_back(values[kIntensity]);
+		} else if(is_ply_) {
+			return false;
+		}
+		p = line_end + 1;
+	}
+	return true;
+}
+
+template <typename T>
+bool TextPointReader<T>::ReadFaces(std::vector<std::array<size_t, 3>>* const triangles) const {
+	triangles->clear();
+	if(!valid_ || face_element_ < 0)
+		return valid_;
+
+	const ply_reader::Element& face = header_.elements[static_cast<size_t>(face_element_)];
+	const int indices = face.FindProperty({"vertex_indices", "vertex_index"});
+	if(indices < 0)
+		return false;
+
+	triangles->resize(face.count);
+	const char* p = data_ + face_offset_;
+	const char* const end = data_ + size_;
+	for(size_t i = 0; i < face.count; ++i) {
+		const void* const newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+		const char* const line_end = newline != nullptr ? static_cast<const char*>(newline) : end;
+		const char* q = SkipSeparators(p, line_end);
+		for(size_t k = 0; k < face.properties.size(); ++k) {
+			size_t count = 1;
+			if(face.properties[k].is_list) {
+				if(!ParseField(q, line_end, &count))
+					return false;
+				q = SkipSeparators(q, line_end);
+				if(static_cast<int>(k) == indices && count != 3)
+					return false;
+			}
+			for(size_t j = 0; j < count; ++j) {
+				if(q >= line_end)
+					return false;
+				if(static_cast<int>(k) == indices) {
+					if(!ParseField(q, line_end, &(*triangles)[i][j]))
+						return false;
+				} else {
+					q = SkipField(q, line_end);
+				}
+				q = SkipSeparators(q, line_end);
+			}
+		}
+		if(line_end == end && i + 1 < face.count)
+			return false;
+		p = line_end + 1;
+	}
+	return true;
+}
+
+template <typename T>
+bool TextPointReader<T>::OpenPly() {
+	if(!ply_reader::ParseHeader(reinterpret_cast<const uint8_t*>(data_), size_, &header_)
+		|| header_.format != ply_reader::Format::kAscii)
+		return false;
+
+	// every record is one line, elements are located by counting lines
+	int vertex_element = -1;
+	size_t vertex_offset = 0;
+	size_t offset = header_.data_offset;
+	for(size_t e = 0; e < header_.elements.size() && offset < size_; ++e) {
+		const ply_reader::Element& element = header_.elements[e];
+		if(element.name == "vertex" && vertex_element < 0) {
+			vertex_element = static_cast<int>(e);
+			vertex_offset = offset;
+		} else if(element.name == "face" && face_element_ < 0) {
+			face_element_ = static_cast<int>(e);
+			face_offset_ = offset;
+		}
+		offset = SkipLines(offset, element.count);
+	}
+	if(vertex_element < 0)
+		return false;
+
+	const ply_reader::Element& vertex = header_.elements[static_cast<size_t>(vertex_element)];
+	for(size_t p = 0; p < vertex.properties.size(); ++p) {
+		if(vertex.properties[p].is_list)
+			return false;
+		MapField(p, vertex.properties[p].name);
+	}
+	const int red = vertex.FindProperty({"red", "r", "diffuse_red"});
+	if(red >= 0)
+		color_type_ = vertex.properties[static_cast<size_t>(red)].type;
+
+	const size_t vertex_end = SkipLines(vertex_offset, vertex.count);
+	for(size_t begin = vertex_offset; begin < vertex_end;) {
+		size_t end = std::min(begin + kBytesPerRange, vertex_end);
+		if(end < vertex_end)
+			end = SkipLines(end, 1);
+		ranges_.push_back({begin, std::min(end, vertex_end)});
+		begin = end;
+	}
+	return true;
+}
+
+template <typename T>
+bool TextPointReader<T>::OpenXyz() {
+	size_t data_offset = size_;
+	for(size_t line = 0, offset = 0; line < kMaxHeaderLines && offset < size_; ++line) {
+		const size_t next_offset = SkipLines(offset, 1);
+		const std::vector<std::string> fields = SplitFields(data_ + offset, data_ + next_offset);
+		const bool numbers = std::all_of(fields.begin(), fields.end(), IsNumber);
+		if(numbers && fields.size() >= 3) {
+			// the first point line, fields are known by their count unless a header line named them
+			if(fields_[kX] < 0) {
+				const size_t colors = fields.size() == 7 ? 4 : 3;
+				MapField(0, "x");
+				MapField(1, "y");
+				MapField(2, "z");
+				if(fields.size() == 4 || fields.size() == 7)
+					MapField(3, "intensity");
+				if(fields.size() >= 6) {
+					MapField(colors, "red");
+					MapField(colors + 1, "green");
+					MapField(colors + 2, "blue");
+				}
+			}
+			data_offset = offset;
+			break;
+		}
+		if(!numbers && fields_[kX] < 0) {
+			// a header line naming the fields, possibly behind a comment marker
+			const char* names_begin = SkipSeparators(data_ + offset, data_ + next_offset);
+			while(names_begin < data_ + next_offset && (*names_begin == '/' || *names_begin == '#'))
+				++names_begin;
+			const std::vector<std::string> names = SplitFields(names_begin, data_ + next_offset);
+			for(size_t f = 0; f < names.size(); ++f)
+				MapField(f, names[f]);
+			if(fields_[kX] < 0 || fields_[kY] < 0 || fields_[kZ] < 0) {
+				fields_.fill(-1);
+				field_slots_.clear();
+				num_mapped_fields_ = 0;
+			}
+		}
+		offset = next_offset;
+	}
+
+	for(size_t begin = data_offset; begin < size_;) {
+		const size_t end = SkipLines(std::min(begin + kBytesPerRange, size_), 1);
+		ranges_.push_back({begin, end});
+		begin = end;
+	}
+	return true;
+}
+
+template <typename T>
+void TextPointReader<T>::MapField(
+		const size_t field,
+		const std::string& name
+		) {
+	std::string lower_name = name;
+	std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), [](const unsigned char c) {
+		return static_cast<char>(std::tolower(c));
+	});
+
+	const std::array<std::vector<std::string>, kNumSlots> slot_names = {{
+		{"x"},
+		{"y"},
+		{"z"},
+		{"red", "r", "diffuse_red"},
+		{"green", "g", "diffuse_green"},
+		{"blue", "b", "diffuse_blue"},
+		{"nx", "normal_x"},
+		{"ny", "normal_y"},
+		{"nz", "normal_z"},
+		{"intensity_value", "intensity", "scalar_intensity", "i"}
+	}};
+	for(size_t slot = 0; slot < kNumSlots; ++slot) {
+		if(fields_[slot] >= 0 || std::find(slot_names[slot].begin(), slot_names[slot].end(), lower_name) == slot_names[slot].end())
+			continue;
+		fields_[slot] = static_cast<int>(field);
+		if(field_slots_.size() <= field)
+			field_slots_.resize(field + 1, -1);
+		field_slots_[field] = static_cast<int>(slot);
+		++num_mapped_fields_;
+		return;
+	}
+}
+
+template <typename T>
+bool TextPointReader<T>::ParseLine(
+		const char* const begin,
+		const char* const end,
+		std::array<T, kNumSlots>* const values
+		) const {
+	const char* p = SkipSeparators(begin, end);
+	size_t num_parsed = 0;
+	for(size_t field = 0; p < end && num_parsed < num_mapped_fields_; ++field) {
+		const int slot = field < field_slots_.size() ? field_slots_[field] : -1;
+		if(slot >= 0) {
+			if(!ParseField(p, end, &(*values)[static_cast<size_t>(slot)]))
+				return false;
+			++num_parsed;
+		} else {
+			p = SkipField(p, end);
+		}
+		p = SkipSeparators(p, end);
+	}
+	return num_parsed == num_mapped_fields_;
+}
+
+template <typename T>
+size_t TextPointReader<T>::SkipLines(
+		const size_t begin,
+		const size_t count
+		) const {
+	size_t position = begin;
+	for(size_t i = 0; i < count && position < size_; ++i) {
+		const void* const newline = std::memchr(data_ + position, '\n', size_ - position);
+		position = newline != nullptr ? static_cast<size_t>(static_cast<const char*>(newline) - data_) + 1 : size_;
+	}
+	return position;
+}
+
+template class TextPointReader<float>;
+template class TextPointReader<double>;
+
+} // namespace point_reader
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+#include <FileIO/PointReader.h>
+#include <FileIO/PlyReader.h>
+
+namespace point_reader {
+
+///
+/// Memory mapped reader for text point files, either ASCII PLY or a point per line (XYZ, CSV, PTS).
+/// The point lines are split into ranges of about 4 MB at newline boundaries and the numbers are parsed with
+/// std::from_chars, so ranges are parsed concurrently without locale or stream overhead.
+///
+/// The fields of ASCII PLY files come from the header. In other text files fields are separated by spaces, tabs,
+/// commas or semicolons and are named by an optional header line (x, y, z, red or r, ...). Without one they are
+/// x y z, x y z intensity, x y z r g b or x y z intensity r g b (PTS) by their count. Lines that do not hold
+/// the fields, like comments or the point count of PTS files, are skipped.
+///
+template <typename T>
+class TextPointReader : public PointReader<T> {
+public:
+	explicit TextPointReader(const std::string& file);
+	~TextPointReader();
+
+	TextPointReader(const TextPointReader&) = delete;
+	TextPointReader& operator=(const TextPointReader&) = delete;
+
+	bool IsOpen() const override final {
+		return valid_;
+	}
+
+	///
+	/// True if the file is an ASCII PLY file.
+	///
+	bool IsPly() const {
+		return is_ply_;
+	}
+
+	bool HasColors() const override final {
+		return fields_[kRed] >= 0 && fields_[kGreen] >= 0 && fields_[kBlue] >= 0;
+	}
+
+	bool HasNormals() const override final {
+		return fields_[kNx] >= 0 && fields_[kNy] >= 0 && fields_[kNz] >= 0;
+	}
+
+	bool HasIntensities() const override final {
+		return fields_[kIntensity] >= 0;
+	}
+
+	size_t NumRanges() const override final {
+		return ranges_.size();
+	}
+
+	///
+	/// Parses the point lines of the range. Fails on a malformed vertex line of a PLY file.
+	///
+	bool ReadRange(
+		const size_t range,
+		geometry::PointCloud<T>* const points
+		) const override final;
+
+	///
+	/// Reads the vertex indices of the face element of a PLY file. Returns false if a face is not a triangle.
+	///
+	bool ReadFaces(std::vector<std::array<size_t, 3>>* const triangles) const;
+
+private:
+	enum Slot {
+		kX,
+		kY,
+		kZ,
+		kRed,
+		kGreen,
+		kBlue,
+		kNx,
+		kNy,
+		kNz,
+		kIntensity,
+		kNumSlots
+	};
+
+	bool OpenPly();
+
+	bool OpenXyz();
+
+	///
+	/// Maps the field to the slot of the first of the names it matches, case insensitive.
+	///
+	void MapField(
+		const size_t field,
+		const std::string& name
+		);
+
+	///
+	/// Parses the fields of one line into the slots. Returns false if a mapped field is missing or not a number.
+	///
+	bool ParseLine(
+		const char* const begin,
+		const char* const end,
+		std::array<T, kNumSlots>* const values
+		) const;
+
+	///
+	/// Position after the end of the count lines starting at begin, size_ if the file ends before.
+	///
+	size_t SkipLines(
+		const size_t begin,
+		const size_t count
+		) const;
+
+	int fd_ = -1;
+	const char* data_ = nullptr;
+	size_t size_ = 0;
+	bool valid_ = false;
+	bool is_ply_ = false;
+
+	// field index of every slot, -1 if missing, and the slot of every field, -1 if it is skipped
+	std::array<int, kNumSlots> fields_;
+	std::vector<int> field_slots_;
+	size_t num_mapped_fields_ = 0;
+	ply_reader::ScalarType color_type_ = ply_reader::ScalarType::kUint8;
+
+	// byte ranges of the point lines
+	std::vector<std::pair<size_t, size_t>> ranges_;
+
+	// PLY header and byte offset of the face element, -1 if there is none
+	ply_reader::Header header_;
+	int face_element_ = -1;
+	size_t face_offset_ = 0;
+};
+
+} // namespace point_reader
@@ -0,0 +1,185 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+namespace geometry {
+
+///
+/// Structure of arrays point cloud.
+/// Coordinates are three separate columns, colors, normals and intensities are optional columns that only exist
+/// if they were enabled. Columns are 16 byte aligned so SIMD kernels can run over them directly.
+/// A float cloud with colors takes 15 bytes per point, a vector of Point<float> 48.
+///
+template <typename T>
+class PointCloud {
+public:
+	template <typename U>
+	using Column = std::vector<U, Eigen::aligned_allocator<U>>;
+
+	size_t Size() const {
+		return x_.size();
+	}
+
+	bool Empty() const {
+		return x_.empty();
+	}
+
+	///
+	/// Resizes all existing columns. New points are zero.
+	///
+	void Resize(const size_t size) {
+		x_.resize(size);
+		y_.resize(size);
+		z_.resize(size);
+		if(has_colors_)
+			colors_.resize(size);
+		if(has_normals_) {
+			nx_.resize(size);
+			ny_.resize(size);
+			nz_.resize(size);
+		}
+		if(has_intensities_)
+			intensities_.resize(size);
+	}
+
+	void Reserve(const size_t size) {
+		x_.reserve(size);
+		y_.reserve(size);
+		z_.reserve(size);
+		if(has_colors_)
+			colors_.reserve(size);
+		if(has_normals_) {
+			nx_.reserve(size);
+			ny_.reserve(size);
+			nz_.reserve(size);
+		}
+		if(has_intensities_)
+			intensities_.reserve(size);
+	}
+
+	///
+	/// Removes all points and optional columns.
+	///
+	void Clear() {
+		*this = PointCloud<T>();
+	}
+
+	///
+	/// Adds the optional columns, sized like the coordinates.
+	///
+	void EnableColors() {
+		has_colors_ = true;
+		colors_.resize(Size());
+	}
+
+	void EnableNormals() {
+		has_normals_ = true;
+		nx_.resize(Size());
+		ny_.resize(Size());
+		nz_.resize(Size());
+	}
+
+	void EnableIntensities() {
+		has_intensities_ = true;
+		intensities_.resize(Size());
+	}
+
+	bool HasColors() const {
+		return has_colors_;
+	}
+
+	bool HasNormals() const {
+		return has_normals_;
+	}
+
+	bool HasIntensities() const {
+		return has_intensities_;
+	}
+
+	///
+	/// Appends a point. Optional columns that exist get the given values.
+	///
+	void PushBack(
+		const Eigen::Matrix<T, 3, 1>& xyz,
+		const std::array<uint8_t, 3>& rgb = {{0, 0, 0}},
+		const Eigen::Matrix<T, 3, 1>& normal = Eigen::Matrix<T, 3, 1>::Zero(),
+		const T intensity = static_cast<T>(-1.0)
+		) {
+		x_.push_back(xyz(0));
+		y_.push_back(xyz(1));
+		z_.push_back(xyz(2));
+		if(has_colors_)
+			colors_.push_back(rgb);
+		if(has_normals_) {
+			nx_.push_back(normal(0));
+			ny_.push_back(normal(1));
+			nz_.push_back(normal(2));
+		}
+		if(has_intensities_)
+			intensities_.push_back(intensity);
+	}
+
+	Eigen::Matrix<T, 3, 1> Xyz(const size_t i) const {
+		return Eigen::Matrix<T, 3, 1>(x_[i], y_[i], z_[i]);
+	}
+
+	void SetXyz(const size_t i, const Eigen::Matrix<T, 3, 1>& xyz) {
+		x_[i] = xyz(0);
+		y_[i] = xyz(1);
+		z_[i] = xyz(2);
+	}
+
+	Eigen::Matrix<T, 3, 1> Normal(const size_t i) const {
+		return Eigen::Matrix<T, 3, 1>(nx_[i], ny_[i], nz_[i]);
+	}
+
+	void SetNormal(const size_t i, const Eigen::Matrix<T, 3, 1>& normal) {
+		nx_[i] = normal(0);
+		ny_[i] = normal(1);
+		nz_[i] = normal(2);
+	}
+
+	///
+	/// Column accessors. Optional columns are empty if they are not enabled.
+	///
+	Column<T>& X() { return x_; }
+	Column<T>& Y() { return y_; }
+	Column<T>& Z() { return z_; }
+	Column<std::array<uint8_t, 3>>& Colors() { return colors_; }
+	Column<T>& Nx() { return nx_; }
+	Column<T>& Ny() { return ny_; }
+	Column<T>& Nz() { return nz_; }
+	Column<T>& Intensities() { return intensities_; }
+
+	const Column<T>& X() const { return x_; }
+	const Column<T>& Y() const { return y_; }
+	const Column<T>& Z() const { return z_; }
+	const Column<std::array<uint8_t, 3>>& Colors() const { return colors_; }
+	const Column<T>& Nx() const { return nx_; }
+	const Column<T>& Ny() const { return ny_; }
+	const Column<T>& Nz() const { return nz_; }
+	const Column<T>& Intensities() const { return intensities_; }
+
+private:
+	Column<T> x_;
+	Column<T> y_;
+	Column<T> z_;
+
+	bool has_colors_ = false;
+	Column<std::array<uint8_t, 3>> colors_;
+
+	bool has_normals_ = false;
+	Column<T> nx_;
+	Column<T> ny_;
+	Column<T> nz_;
+
+	bool has_intensities_ = false;
+	Column<T> intensities_;
+};
+
+} // namespace geometry
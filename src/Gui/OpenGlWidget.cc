@@ -118,7 +118,13 @@ Eigen::Matrix<T, 4, 4> InverseTransform(const Eigen::Matrix<T, 4, 4>& transform)
 namespace gui {
 
 template <typename T>
-OpenGlWidget<T>::OpenGlWidget(const octree_reader::OctreeReader& octree_reader) : octree_reader_(octree_reader) {
+OpenGlWidget<T>::OpenGlWidget(
+    const octree_reader::OctreeReader& octree_reader,
+    const size_t gpu_memory_budget,
+    const size_t read_coalescing_gap
+    ) : octree_reader_(octree_reader),
+    gpu_memory_budget_(gpu_memory_budget),
+    read_coalescing_gap_(read_coalescing_gap) {
     prev_draw_time_ = std::chrono::high_resolution_clock::now();
 
     current_b2v_ = YawPitchRollTranslationToMatrix(
@@ -142,7 +148,7 @@ OpenGlWidget<T>::OpenGlWidget(const octree_reader::OctreeReader& octree_reader)
 template <typename T>
 void OpenGlWidget<T>::InitAllViews() {
     const size_t screen_num_pixels = static_cast<size_t>(QApplication::desktop()->screenGeometry().height() * QApplication::desktop()->screenGeometry().width());
-    octree_view_.reset(new OctreeView(octree_reader_, screen_num_pixels));
+    octree_view_.reset(new OctreeView(octree_reader_, screen_num_pixels, 10.0f, gpu_memory_budget_, read_coalescing_gap_));
 }
 
 template <typename T>
@@ -319,6 +325,20 @@ void OpenGlWidget<T>::SetOctreePointSize(const float point_size) {
 }
 
 
+template <typename T>
+float OpenGlWidget<T>::GetLoadingProgress() const {
+    if(octree_view_ == nullptr)
+        return 0.0f;
+    return reinterpret_cast<OctreeView*>(octree_view_.get())->GetLoadingProgress();
+}
+
+template <typename T>
+GpuResidency::Counters OpenGlWidget<T>::GetResidencyCounters() const {
+    if(octree_view_ == nullptr)
+        return GpuResidency::Counters();
+    return reinterpret_cast<OctreeView*>(octree_view_.get())->GetResidencyCounters();
+}
+
 template <typename T>
 void OpenGlWidget<T>::ProcessPointSizeSelection() {
     if(octree_view_->IsInitialized())
@@ -28,9 +28,12 @@ class OpenGlWidget final : public QOpenGLWidget, protected QOpenGLExtraFunctions
 public:
     ///
     /// Constructor with reference to an octree reader instance.
+    /// The gpu memory budget and the read coalescing gap are passed on to the octree view.
     ///
     OpenGlWidget(
-        const octree_reader::OctreeReader& octree_reader
+        const octree_reader::OctreeReader& octree_reader,
+        const size_t gpu_memory_budget,
+        const size_t read_coalescing_gap
         );
 
     ///
@@ -71,6 +74,16 @@ public:
     ///
     void SetOctreePointSize(const float point_size);
 
+    ///
+    /// Returns the fraction of the octree's level 0 that is loaded, in [0, 1].
+    ///
+    float GetLoadingProgress() const;
+
+    ///
+    /// Returns the statistics of the gpu residency of the octree's detail levels.
+    ///
+    GpuResidency::Counters GetResidencyCounters() const;
+
 private:
     ///
     /// Adjusts translation of the view matrix based on the state booleans.
@@ -133,6 +146,8 @@ private:
 
 private:
     const octree_reader::OctreeReader& octree_reader_;
+    const size_t gpu_memory_budget_;
+    const size_t read_coalescing_gap_;
 
     // variables for handling translation of view
     bool translating_forward_ = false;
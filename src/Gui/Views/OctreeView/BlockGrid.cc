@@ -0,0 +1,140 @@
+#include "BlockGrid.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+namespace {
+
+///
+/// Squared distance from a coordinate to an interval, and squared distance to the interval's farther end.
+///
+std::pair<float, float> IntervalDistancesSquared(
+	const float x,
+	const float lower,
+	const float upper
+	) {
+	const float near = (x < lower ? lower - x : (x > upper ? x - upper : 0.0f));
+	const float far = std::max(std::abs(x - lower), std::abs(x - upper));
+	return {near * near, far * far};
+}
+
+} // namespace
+
+namespace gui {
+
+BlockGrid::BlockGrid(
+	const std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>& centers,
+	const float cell_size
+	) : cell_size_(cell_size),
+		inverse_cell_size_(1.0f / cell_size) {
+	if(centers.empty())
+		return;
+
+	std::vector<int64_t> cell_ids(centers.size());
+	min_cell_ = {{INT64_MAX, INT64_MAX, INT64_MAX}};
+	max_cell_ = {{INT64_MIN, INT64_MIN, INT64_MIN}};
+	for(size_t i=0; i < centers.size(); ++i) {
+		const std::array<int64_t, 3> ijk = {{
+			CellPosition(centers[i](0)),
+			CellPosition(centers[i](1)),
+			CellPosition(centers[i](2))
+		}};
+		for(size_t j=0; j < 3; ++j) {
+			min_cell_[j] = std::min(min_cell_[j], ijk[j]);
+			max_cell_[j] = std::max(max_cell_[j], ijk[j]);
+		}
+		cell_ids[i] = CellId(ijk[0], ijk[1], ijk[2]);
+	}
+
+	block_.resize(centers.size());
+	std::iota(block_.begin(), block_.end(), 0);
+	std::sort(block_.begin(), block_.end(), [&](const size_t a, const size_t b) {
+		return cell_ids[a] < cell_ids[b];
+	});
+
+	x_.resize(centers.size());
+	y_.resize(centers.size());
+	z_.resize(centers.size());
+	for(size_t i=0; i < block_.size(); ++i) {
+		x_[i] = centers[block_[i]](0);
+		y_[i] = centers[block_[i]](1);
+		z_[i] = centers[block_[i]](2);
+	}
+
+	size_t begin = 0;
+	for(size_t i=1; i <= block_.size(); ++i) {
+		if(i == block_.size() || cell_ids[block_[i]] != cell_ids[block_[begin]]) {
+			cells_.insert({cell_ids[block_[begin]], {begin, i}});
+			begin = i;
+		}
+	}
+}
+
+void BlockGrid::QueryShell(
+	const Eigen::Matrix<float, 4, 1>& position,
+	const float min_radius,
+	const float max_radius,
+	std::vector<size_t>* const blocks
+	) const {
+	if(max_radius < 0.0f || max_radius < min_radius || block_.empty())
+		return;
+
+	const float min_radius_squared = (min_radius > 0.0f ? min_radius * min_radius : 0.0f);
+	const float max_radius_squared = max_radius * max_radius;
+
+	std::array<int64_t, 3> lower;
+	std::array<int64_t, 3> upper;
+	for(size_t j=0; j < 3; ++j) {
+		const Eigen::Index jj = static_cast<Eigen::Index>(j);
+		lower[j] = std::max(min_cell_[j], CellPosition(position(jj) - max_radius));
+		upper[j] = std::min(max_cell_[j], CellPosition(position(jj) + max_radius));
+	}
+
+	for(int64_t k = lower[2]; k <= upper[2]; ++k) {
+		const std::pair<float, float> dz = IntervalDistancesSquared(position(2), 
+			static_cast<float>(k) * cell_size_, static_cast<float>(k + 1) * cell_size_);
+		for(int64_t j = lower[1]; j <= upper[1]; ++j) {
+			const std::pair<float, float> dy = IntervalDistancesSquared(position(1), 
+				static_cast<float>(j) * cell_size_, static_cast<float>(j + 1) * cell_size_);
+			for(int64_t i = lower[0]; i <= upper[0]; ++i) {
+				const std::pair<float, float> dx = IntervalDistancesSquared(position(0), 
+					static_cast<float>(i) * cell_size_, static_cast<float>(i + 1) * cell_size_);
+
+				// skip cells that lie completely inside the inner or outside the outer sphere
+				if(dx.first + dy.first + dz.first > max_radius_squared)
+					continue;
+				if(dx.second + dy.second + dz.second < min_radius_squared)
+					continue;
+
+				const auto cell = cells_.find(CellId(i, j, k));
+				if(cell == cells_.end())
+					continue;
+
+				for(size_t n = cell->second.first; n < cell->second.second; ++n) {
+					const float ddx = x_[n] - position(0);
+					const float ddy = y_[n] - position(1);
+					const float ddz = z_[n] - position(2);
+					const float dist_squared = ddx * ddx + ddy * ddy + ddz * ddz;
+					if(dist_squared >= min_radius_squared && dist_squared <= max_radius_squared)
+						blocks->push_back(block_[n]);
+				}
+			}
+		}
+	}
+}
+
+int64_t BlockGrid::CellPosition(const float coordinate) const {
+	return static_cast<int64_t>(std::floor(coordinate * inverse_cell_size_));
+}
+
+int64_t BlockGrid::CellId(
+	const int64_t i,
+	const int64_t j,
+	const int64_t k
+	) {
+	const int64_t hash_range = 100000;
+	return (i+hash_range) + 2*hash_range*(j+hash_range) + 4*hash_range*hash_range*(k+hash_range);
+}
+
+} // namespace gui
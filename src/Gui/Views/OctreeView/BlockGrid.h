@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <cstdint>
+
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+
+namespace gui {
+
+///
+/// Uniform grid over the centers of the octree blocks to answer distance queries
+/// without touching every block.
+/// Centers are kept as structure of arrays, sorted by grid cell.
+///
+class BlockGrid {
+public:
+	///
+	/// Constructor. Builds the grid from the block centers, the index of a center is the block index.
+	///
+	BlockGrid(
+		const std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>& centers,
+		const float cell_size
+		);
+
+	///
+	/// Appends the blocks whose center distance to the position lies within [min_radius, max_radius].
+	///
+	void QueryShell(
+		const Eigen::Matrix<float, 4, 1>& position,
+		const float min_radius,
+		const float max_radius,
+		std::vector<size_t>* const blocks
+		) const;
+
+	///
+	/// Number of blocks in the grid.
+	///
+	size_t Size() const {
+		return block_.size();
+	}
+
+private:
+	///
+	/// Cell index of a coordinate.
+	///
+	int64_t CellPosition(const float coordinate) const;
+
+	///
+	/// Serial id of a cell.
+	///
+	static int64_t CellId(
+		const int64_t i,
+		const int64_t j,
+		const int64_t k
+		);
+
+private:
+	const float cell_size_;
+	const float inverse_cell_size_;
+
+	// block data sorted by cell
+	std::vector<float> x_;
+	std::vector<float> y_;
+	std::vector<float> z_;
+	std::vector<size_t> block_;
+
+	// cell id -> [begin, end) in the arrays above
+	std::unordered_map<int64_t, std::pair<size_t, size_t>> cells_;
+	std::array<int64_t, 3> min_cell_ = {{0, 0, 0}};
+	std::array<int64_t, 3> max_cell_ = {{-1, -1, -1}};
+};
+
+} // namespace gui
@@ -0,0 +1,99 @@
+#include "GpuResidency.h"
+
+#include <algorithm>
+
+namespace gui {
+
+GpuResidency::GpuResidency(
+	const size_t num_blocks,
+	const size_t budget_bytes
+	) : budget_bytes_(budget_bytes),
+		entries_(num_blocks) {
+	counters_.budget_bytes = budget_bytes;
+}
+
+bool GpuResidency::Reuse(
+	const size_t block,
+	const size_t level
+	) {
+	Entry& entry = entries_.at(block);
+	if(entry.level == 0 || entry.level != level)
+		return false;
+
+	if(!entry.visible)
+		hidden_lru_.erase({entry.last_used, block});
+	entry.visible = true;
+	entry.last_used = ++tick_;
+
+	std::lock_guard<std::mutex> lock(counters_mutex_);
+	++counters_.num_cache_hits;
+	return true;
+}
+
+void GpuResidency::Upload(
+	const size_t block,
+	const size_t level,
+	const size_t num_bytes
+	) {
+	if(entries_.at(block).level != 0)
+		Release(block);
+
+	Entry& entry = entries_.at(block);
+	entry.level = level;
+	entry.num_bytes = num_bytes;
+	entry.visible = true;
+	entry.last_used = ++tick_;
+
+	std::lock_guard<std::mutex> lock(counters_mutex_);
+	counters_.resident_bytes += num_bytes;
+	counters_.peak_resident_bytes = std::max(counters_.peak_resident_bytes, counters_.resident_bytes);
+	++counters_.num_resident_blocks;
+	++counters_.num_uploads;
+}
+
+void GpuResidency::Hide(const size_t block) {
+	Entry& entry = entries_.at(block);
+	if(!entry.visible)
+		return;
+	entry.visible = false;
+	entry.last_used = ++tick_;
+	if(entry.level != 0)
+		hidden_lru_.insert({entry.last_used, block});
+}
+
+std::vector<std::pair<size_t, size_t>> GpuResidency::CollectEvictions() {
+	std::vector<std::pair<size_t, size_t>> evicted;
+	while(!hidden_lru_.empty() && GetCounters().resident_bytes > budget_bytes_) {
+		const size_t block = hidden_lru_.begin()->second;
+		const size_t num_bytes = entries_[block].num_bytes;
+		evicted.push_back({block, entries_[block].level});
+		Release(block);
+
+		std::lock_guard<std::mutex> lock(counters_mutex_);
+		++counters_.num_evictions;
+		counters_.evicted_bytes += num_bytes;
+	}
+	return evicted;
+}
+
+GpuResidency::Counters GpuResidency::GetCounters() const {
+	std::lock_guard<std::mutex> lock(counters_mutex_);
+	return counters_;
+}
+
+void GpuResidency::Release(const size_t block) {
+	Entry& entry = entries_.at(block);
+	if(!entry.visible)
+		hidden_lru_.erase({entry.last_used, block});
+
+	{
+		std::lock_guard<std::mutex> lock(counters_mutex_);
+		counters_.resident_bytes -= entry.num_bytes;
+		--counters_.num_resident_blocks;
+	}
+
+	entry.level = 0;
+	entry.num_bytes = 0;
+}
+
+} // namespace gui
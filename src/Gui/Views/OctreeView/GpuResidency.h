@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <utility>
+#include <cstdint>
+
+namespace gui {
+
+///
+/// Book keeping of the gpu buffers owned by the detail views of the octree blocks.
+/// Blocks that return to level 0 stay resident as a cache until the memory budget is exceeded.
+/// Eviction policy: least recently used hidden blocks go first, visible blocks are never evicted.
+/// Not thread safe except for the counters accessor.
+///
+class GpuResidency {
+public:
+	///
+	/// Statistics of the residency handling.
+	///
+	struct Counters {
+		size_t budget_bytes = 0;
+		size_t resident_bytes = 0;
+		size_t peak_resident_bytes = 0;
+		size_t num_resident_blocks = 0;
+		size_t num_uploads = 0;
+		size_t num_cache_hits = 0;
+		size_t num_evictions = 0;
+		size_t evicted_bytes = 0;
+	};
+
+	///
+	/// Constructor. 
+	/// Budget in bytes of gpu memory the detail views may occupy.
+	///
+	GpuResidency(
+		const size_t num_blocks,
+		const size_t budget_bytes
+		);
+
+	///
+	/// Marks the block as visible again if its buffers still hold the requested level.
+	/// Returns false if the level has to be loaded and uploaded.
+	///
+	bool Reuse(
+		const size_t block,
+		const size_t level
+		);
+
+	///
+	/// Registers a new upload of the block with the given level.
+	/// Replaces whatever the block had resident before. Block counts as visible.
+	///
+	void Upload(
+		const size_t block,
+		const size_t level,
+		const size_t num_bytes
+		);
+
+	///
+	/// Marks the block as hidden, its buffers become candidates for eviction.
+	///
+	void Hide(const size_t block);
+
+	///
+	/// Returns the (block, level) pairs whose buffers have to be released to get back under the budget.
+	/// The returned blocks are considered non resident afterwards.
+	///
+	std::vector<std::pair<size_t, size_t>> CollectEvictions();
+
+	///
+	/// Copy of the current statistics.
+	///
+	Counters GetCounters() const;
+
+private:
+	///
+	/// Removes the block from the residency set and updates the counters.
+	///
+	void Release(const size_t block);
+
+private:
+	struct Entry {
+		size_t level = 0; // 0 means nothing resident
+		size_t num_bytes = 0;
+		uint64_t last_used = 0;
+		bool visible = false;
+	};
+
+	const size_t budget_bytes_;
+	std::vector<Entry> entries_;
+	std::set<std::pair<uint64_t, size_t>> hidden_lru_; // (last used tick, block)
+	uint64_t tick_ = 0;
+
+	Counters counters_;
+	mutable std::mutex counters_mutex_;
+};
+
+} // namespace gui
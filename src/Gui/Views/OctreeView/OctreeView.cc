@@ -1,8 +1,14 @@
 #include "OctreeView.h"
 
 #include <array>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
-#include <FileIO/BinaryIO.h>
+#include <FileIO/PointRecords.h>
+#include <FileIO/OctreeLayout.h>
+#include <FileIO/BlockCodec.h>
 
 namespace {
 
@@ -34,40 +40,130 @@ Eigen::Matrix<float, 4, 1> GetVoxelCenter(
 	return GetVoxelCenter(position, voxel_size);
 }
 
-void ReadPoints(
-	const std::string& bin_file,
-	const size_t offset,
-	const size_t num_bytes,
+///
+/// Appends the points of a block payload as floats.
+/// Quantized records are dequantized relative to the cell of the block.
+///
+void DecodePoints(
+	const uint8_t* const data,
+	const size_t size,
+	const point_records::Encoding encoding,
+	const uint64_t hash,
 	std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>* const points,
 	std::vector<std::array<uint8_t, 4>>* const colors 
 	) {
-	binary_io::BinaryReader bin(bin_file);
-	bin.Seek(offset);
-
-	Eigen::Matrix<float, 4, 1> xyz;
-	xyz(3) = 1.0f;
-	std::array<uint8_t, 4> rgb;
-	rgb[3] = 255;
-
-	size_t num_bytes_read = 0;
-
-	while(
-		bin.Read<float>(&(xyz(0))) 
-		&& bin.Read<float>(&(xyz(1))) 
-		&& bin.Read<float>(&(xyz(2))) 
-		&& bin.Read<uint8_t>(&(rgb[0])) 
-		&& bin.Read<uint8_t>(&(rgb[1])) 
-		&& bin.Read<uint8_t>(&(rgb[2]))
-		) {
-		points->push_back(xyz);
-		colors->push_back(rgb);
+	const size_t record_size = point_records::RecordSize(encoding);
+	const size_t num_points = size / record_size;
+	if(num_points == 0)
+		return;
+	const size_t first = points->size();
+	points->resize(first + num_points);
+	colors->resize(first + num_points);
+
+	const uint8_t* record = data;
+	if(encoding == point_records::Encoding::kXyzRgbQuantized) {
+		const std::array<float, 3> origin = octree_layout::BlockOrigin(hash);
+		point_records::XyzRgbQuantized quantized;
+		for(size_t i = first; i < first + num_points; ++i, record += record_size) {
+			std::memcpy(&quantized, record, record_size);
+			const point_records::XyzRgb dequantized = point_records::Dequantize(quantized, origin, octree_layout::kLevel0CellSize);
+			(*points)[i] << dequantized.xyz[0], dequantized.xyz[1], dequantized.xyz[2], 1.0f;
+			(*colors)[i] = {{quantized.rgb[0], quantized.rgb[1], quantized.rgb[2], 255}};
+		}
+		return;
+	}
 
-		num_bytes_read += 3 * (sizeof(float) + sizeof(uint8_t));
-		if(num_bytes_read == num_bytes)
-			break;
+	if(encoding == point_records::Encoding::kXyzRgba) {
+		point_records::DecodeXyzRgba(
+			record,
+			num_points,
+			&((*points)[first](0)),
+			sizeof(Eigen::Matrix<float, 4, 1>),
+			&((*colors)[first][0]),
+			sizeof(std::array<uint8_t, 4>)
+			);
+		return;
+	}
+
+	point_records::DecodeXyzRgb(
+		record,
+		num_points,
+		&((*points)[first](0)),
+		sizeof(Eigen::Matrix<float, 4, 1>),
+		&((*colors)[first][0]),
+		sizeof(std::array<uint8_t, 4>)
+		);
+}
+
+///
+/// Appends the points of a quantized block payload without dequantizing them, the vertex shader does that.
+///
+void DecodeQuantizedPoints(
+	const uint8_t* const data,
+	const size_t size,
+	std::vector<std::array<uint16_t, 4>>* const points,
+	std::vector<std::array<uint8_t, 4>>* const colors 
+	) {
+	const size_t record_size = sizeof(point_records::XyzRgbQuantized);
+	const size_t num_points = size / record_size;
+	const size_t first = points->size();
+	points->resize(first + num_points);
+	colors->resize(first + num_points);
+
+	const uint8_t* record = data;
+	point_records::XyzRgbQuantized quantized;
+	for(size_t i = first; i < first + num_points; ++i, record += record_size) {
+		std::memcpy(&quantized, record, record_size);
+		(*points)[i] = {{quantized.xyz[0], quantized.xyz[1], quantized.xyz[2], 0}};
+		(*colors)[i] = {{quantized.rgb[0], quantized.rgb[1], quantized.rgb[2], 255}};
 	}
 }
 
+///
+/// Decompresses the payload of a block into the buffer if it is compressed.
+/// Returns the records, which are either the payload itself or the buffer. Empty on corrupt payloads.
+///
+octree_reader::BlockSpan DecompressPayload(
+	const octree_reader::OctreeReader& octree_reader,
+	const size_t level,
+	const uint64_t hash,
+	const octree_reader::BlockSpan payload,
+	std::vector<uint8_t>* const buffer
+	) {
+	if(octree_reader.GetCodec(level, hash) == block_codec::Codec::kNone)
+		return payload;
+	if(!block_codec::Decompress(payload.data, payload.size, octree_reader.GetDecodedSize(level, hash), buffer))
+		return octree_reader::BlockSpan();
+	return {buffer->data(), buffer->size()};
+}
+
+///
+/// Reads a block with one positional read into the reusable buffer and appends the decoded points.
+/// The read buffer is not used if the reader has the file memory mapped.
+///
+void ReadPoints(
+	const octree_reader::OctreeReader& octree_reader,
+	const size_t level,
+	const uint64_t hash,
+	std::vector<uint8_t>* const buffer,
+	std::vector<uint8_t>* const decompression_buffer,
+	std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>* const points,
+	std::vector<std::array<uint8_t, 4>>* const colors 
+	) {
+	// memory mapped files are decoded in place, otherwise the block is read into the buffer first
+	octree_reader::BlockSpan span = octree_reader.GetBlockSpan(level, hash);
+	if(span.Empty()) {
+		if(!octree_reader.ReadBlock(level, hash, buffer))
+			return;
+		span.data = buffer->data();
+		span.size = buffer->size();
+	}
+	span = DecompressPayload(octree_reader, level, hash, span, decompression_buffer);
+	if(span.Empty())
+		return;
+	DecodePoints(span.data, span.size, octree_reader.GetEncoding(level, hash), hash, points, colors);
+}
+
 template <typename T>
 Eigen::Matrix<T, 4, 4> InverseTransform(const Eigen::Matrix<T, 4, 4>& T4x4) {
 	Eigen::Matrix<T, 3, 3> R = T4x4.template block<3,3>(0,0);
@@ -93,51 +189,47 @@ void OctreeView::Init() {
 
 	pc_views_.resize(num_blocks);
 	pc_views_active_level_.resize(num_blocks, 0);
+	pc_views_draw_level_0_.reset(new std::atomic<bool>[num_blocks]);
+	pc_views_level_0_loaded_.reset(new std::atomic<bool>[num_blocks]);
+	pc_views_level_0_range_.resize(num_blocks);
+	residency_.reset(new GpuResidency(num_blocks, gpu_memory_budget_));
 
 	for(size_t i=0; i < num_blocks; ++i) {
 		pc_views_[i].reset(new PointCloudView);
 		pc_views_[i]->Initialize();
-	}
-
-	std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> all_l0_points(
-		new std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>());
-	std::unique_ptr<std::vector<std::array<uint8_t, 4>>> all_l0_colors(
-		new std::vector<std::array<uint8_t, 4>>);
-
-	for(size_t i=0; i < num_blocks; ++i) {
-		std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points(
-			new std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>());
-		std::unique_ptr<std::vector<std::array<uint8_t, 4>>> colors(
-			new std::vector<std::array<uint8_t, 4>>);
-		
-		ReadPoints(
-			octree_reader_.GetBinFileName(),
-			octree_reader_.GetOffset(0, static_cast<uint64_t>(pc_views_block_id_[i])),
-			octree_reader_.GetSize(0, static_cast<uint64_t>(pc_views_block_id_[i])),
-			points.get(),
-			colors.get()
-			);
-
-		all_l0_points->insert(all_l0_points->end(), points->begin(), points->end());
-		all_l0_colors->insert(all_l0_colors->end(), colors->begin(), colors->end());
-
-		pc_views_[i]->SetPoints(
-			std::move(points),
-			std::move(colors)
-			);
 		pc_views_[i]->SetHidden(true);
+		pc_views_draw_level_0_[i] = true;
+		pc_views_level_0_loaded_[i] = false;
 	}
 
 	pc_views_centers_.resize(num_blocks);
 	for(size_t i=0; i < num_blocks; ++i) 
 		pc_views_centers_[i] = GetVoxelCenter(pc_views_block_id_[i], voxel_size_);
 
+	// spatial index so the level evaluation only visits blocks whose level might change
+	block_grid_.reset(new BlockGrid(pc_views_centers_, 8.0f * voxel_size_));
+	level_candidates_stamps_.resize(num_blocks, 0);
+	for(size_t level = 1; level < level_boundary_radius_.size(); ++level)
+		level_boundary_radius_[level] = ComputeLevelBoundaryRadius(level);
+	num_blocks_per_level_[0] = num_blocks;
+
+	// level 0 of all blocks lives only in the shared buffer, each block draws its own range of it
+	// the buffer is filled progressively by the level 0 loading threads, see StartLevel0Loading
+	size_t num_l0_points = 0;
+	for(size_t i=0; i < num_blocks; ++i) {
+		const uint64_t hash = static_cast<uint64_t>(pc_views_block_id_[i]);
+		num_l0_points += octree_reader_.GetDecodedSize(0, hash) / point_records::RecordSize(octree_reader_.GetEncoding(0, hash));
+	}
+
+	// memory mapped files are decoded in place, otherwise the detail levels are read asynchronously
+	if(!octree_reader_.IsMemoryMapped()) {
+		block_reader_.reset(new async_io::AsyncReader(octree_reader_.GetBinFileName(), 32));
+		block_reader_->EnableCoalescing(read_coalescing_gap_);
+	}
+
 	pc_level_0_.reset(new PointCloudView);
 	pc_level_0_->Initialize();
-	pc_level_0_->SetPoints(
-		std::move(all_l0_points),
-		std::move(all_l0_colors)
-		);
+	pc_level_0_->Reserve(num_l0_points);
 
     octree_load_thread_.reset(new std::thread([&]() {
     	while(!entered_class_destructor_) {
@@ -160,9 +252,32 @@ void OctreeView::Draw(
 	view_position_ = v2w.block<4,1>(0,3);
 	new_view_position_available_ = true;
 
+	if(level_0_load_threads_.empty())
+		StartLevel0Loading(view_position_);
+
+	// level 0 ranges of blocks that are not refined, adjacent ranges are merged into one draw call.
+	// the blocks are appended to the buffer in load order, so the ranges are sorted by their position in the
+	// buffer before merging. collected before the detail views upload, so a block handing over never leaves a gap
+	level_0_draw_ranges_.clear();
+	for(size_t i=0; i < pc_views_.size(); ++i) {
+		if(!pc_views_level_0_loaded_[i] || !pc_views_draw_level_0_[i] || pc_views_level_0_range_[i].second == 0)
+			continue;
+		level_0_draw_ranges_.push_back(pc_views_level_0_range_[i]);
+	}
+	std::sort(level_0_draw_ranges_.begin(), level_0_draw_ranges_.end());
+	size_t num_merged_ranges = 0;
+	for(const std::pair<GLint, GLsizei>& range : level_0_draw_ranges_) {
+		if(num_merged_ranges > 0 
+			&& level_0_draw_ranges_[num_merged_ranges - 1].first + level_0_draw_ranges_[num_merged_ranges - 1].second == range.first)
+			level_0_draw_ranges_[num_merged_ranges - 1].second += range.second;
+		else
+			level_0_draw_ranges_[num_merged_ranges++] = range;
+	}
+	level_0_draw_ranges_.resize(num_merged_ranges);
+
 	for(size_t i=0; i < pc_views_.size(); ++i)
 		pc_views_[i]->Draw(projection, w2v_tf);
-	pc_level_0_->Draw(projection, w2v_tf);
+	pc_level_0_->DrawRanges(projection, w2v_tf, level_0_draw_ranges_);
 }
 
 void OctreeView::SetPointSize(const float point_size) {
@@ -176,61 +291,288 @@ void OctreeView::LoadOctree() {
 		return;
 	new_view_position_available_ = false;
 
-	/*
-	note:
-	const double constant = 1638570.0; // solve for 7
-	const double constant = 409600.0; // solve for 6
-	const double constant = 819200.0; // solve for 6.5
-	*/
+	const Eigen::Matrix<float, 4, 1> position = view_position_;
+
+	// the level is a step function of the distance, so a block can only change its level if its distance crossed
+	// one of the level boundaries since the last evaluation. distances change at most by the moved distance,
+	// so only the shells of that thickness around the boundaries need to be re-evaluated.
+	const float shell_margin = 1.0f;
+	const float moved = (position - last_evaluated_position_).norm() + shell_margin;
+	level_candidates_.clear();
+	if(!evaluated_once_ || moved > level_boundary_radius_[1]) {
+		block_grid_->QueryShell(position, 0.0f, level_boundary_radius_[1] + shell_margin, &level_candidates_);
+		if(evaluated_once_)
+			block_grid_->QueryShell(last_evaluated_position_, 0.0f, level_boundary_radius_[1] + shell_margin, &level_candidates_);
+	} else {
+		for(size_t level = 1; level < level_boundary_radius_.size(); ++level)
+			block_grid_->QueryShell(position, level_boundary_radius_[level] - moved, level_boundary_radius_[level] + moved, &level_candidates_);
+	}
+	last_evaluated_position_ = position;
+	evaluated_once_ = true;
+	level_candidates_.insert(level_candidates_.end(), blocks_to_retry_.begin(), blocks_to_retry_.end());
+	blocks_to_retry_.clear();
 
-	// set constant such that it fulfills a boundary condition for the level computation
-	// here we say that anything closer than 10m is full level 6 (so lvl 7)
-	const double constant = 1638570.0; 
+	++level_candidates_stamp_;
+	for(const size_t i : level_candidates_) {
+		if(level_candidates_stamps_[i] == level_candidates_stamp_)
+			continue;
+		level_candidates_stamps_[i] = level_candidates_stamp_;
 
-	for(size_t i=0; i < pc_views_.size(); ++i) {
-		const double dist_squared = static_cast<double>((pc_views_centers_[i] - view_position_).squaredNorm());
-		const float level = static_cast<float>(0.7213475 * std::log(constant / dist_squared) + resolution_adjustment_);
-		const size_t discrete_level = (level < 0.0f ? 0 : std::min(static_cast<size_t>(level), static_cast<size_t>(6)));
+		const double dist_squared = static_cast<double>((pc_views_centers_[i] - position).squaredNorm());
+		const size_t discrete_level = ComputeDiscreteLevel(dist_squared);
 
 		if(discrete_level != pc_views_active_level_[i]) {
+			const size_t previous_level = pc_views_active_level_[i];
+			--num_blocks_per_level_[pc_views_active_level_[i]];
+			++num_blocks_per_level_[discrete_level];
 			pc_views_active_level_[i] = discrete_level;
 
 			if(discrete_level == 0) {
+				// the shared level 0 buffer takes over, the detail buffers stay cached until evicted
+				pc_views_draw_level_0_[i] = true;
 				pc_views_[i]->SetHidden(true);
-			} else {
-				std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points(
-					new std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>());
-				std::unique_ptr<std::vector<std::array<uint8_t, 4>>> colors(
-					new std::vector<std::array<uint8_t, 4>>);
-				
-				ReadPoints(
-					octree_reader_.GetBinFileName(),
-					octree_reader_.GetOffset(discrete_level, static_cast<uint64_t>(pc_views_block_id_[i])),
-					octree_reader_.GetSize(discrete_level, static_cast<uint64_t>(pc_views_block_id_[i])),
-					points.get(),
-					colors.get()
-					);
-
-				pc_views_[i]->SetPoints(
-					std::move(points),
-					std::move(colors)
-					);
+				residency_->Hide(i);
+			} else if(residency_->Reuse(i, discrete_level)) {
 				pc_views_[i]->SetHidden(false);
+				pc_views_draw_level_0_[i] = false;
+			} else {
+				blocks_to_load_.push_back(i);
+				blocks_to_load_previous_level_.push_back(previous_level);
+			}
+		}
+	}
+
+	if(block_reader_ != nullptr) {
+		// all reads of this update are in flight at once, blocks are decoded in the order they arrive
+		if(block_buffers_.size() < blocks_to_load_.size())
+			block_buffers_.resize(blocks_to_load_.size());
+		block_read_requests_.clear();
+		for(size_t k = 0; k < blocks_to_load_.size(); ++k) {
+			const size_t i = blocks_to_load_[k];
+			const uint64_t hash = static_cast<uint64_t>(pc_views_block_id_[i]);
+			block_buffers_[k].resize(octree_reader_.GetSize(pc_views_active_level_[i], hash));
+			block_read_requests_.push_back({
+				octree_reader_.GetOffset(pc_views_active_level_[i], hash),
+				block_buffers_[k].size(),
+				block_buffers_[k].data(),
+				k
+			});
+		}
+		block_reader_->Submit(block_read_requests_);
+
+		// every batch of completions is decompressed and decoded in parallel
+		while(block_reader_->NumOutstanding() > 0) {
+			block_read_completions_.clear();
+			block_reader_->Reap(&block_read_completions_);
+			block_gpu_bytes_.resize(block_read_completions_.size());
+			block_shown_.assign(block_read_completions_.size(), 0);
+			#pragma omp parallel for schedule(dynamic)
+			for(size_t c = 0; c < block_read_completions_.size(); ++c) {
+				const size_t k = static_cast<size_t>(block_read_completions_[c].user_data);
+				// failed and short reads are not decoded
+				if(block_read_completions_[c].ok)
+					block_shown_[c] = ShowBlock(blocks_to_load_[k], block_buffers_[k].data(), block_read_completions_[c].bytes_read, &block_gpu_bytes_[c]);
 			}
+			for(size_t c = 0; c < block_read_completions_.size(); ++c) {
+				const size_t k = static_cast<size_t>(block_read_completions_[c].user_data);
+				const size_t i = blocks_to_load_[k];
+				if(block_shown_[c])
+					residency_->Upload(i, pc_views_active_level_[i], block_gpu_bytes_[c]);
+				else
+					RetryBlock(k);
+			}
+		}
+	} else {
+		// let the OS fetch all blocks of this update while the first ones are decoded
+		for(const size_t i : blocks_to_load_)
+			octree_reader_.Prefetch(pc_views_active_level_[i], static_cast<uint64_t>(pc_views_block_id_[i]));
+
+		block_gpu_bytes_.resize(blocks_to_load_.size());
+		block_shown_.assign(blocks_to_load_.size(), 0);
+		#pragma omp parallel for schedule(dynamic)
+		for(size_t k = 0; k < blocks_to_load_.size(); ++k) {
+			const size_t i = blocks_to_load_[k];
+			const octree_reader::BlockSpan span = octree_reader_.GetBlockSpan(pc_views_active_level_[i], static_cast<uint64_t>(pc_views_block_id_[i]));
+			block_shown_[k] = ShowBlock(i, span.data, span.size, &block_gpu_bytes_[k]);
+		}
+		for(size_t k = 0; k < blocks_to_load_.size(); ++k) {
+			if(block_shown_[k])
+				residency_->Upload(blocks_to_load_[k], pc_views_active_level_[blocks_to_load_[k]], block_gpu_bytes_[k]);
+			else
+				RetryBlock(k);
+		}
+	}
+	blocks_to_load_.clear();
+	blocks_to_load_previous_level_.clear();
+
+	for(const std::pair<size_t, size_t>& block_level : residency_->CollectEvictions()) {
+		pc_views_[block_level.first]->ClearPoints();
+		octree_reader_.Evict(block_level.second, static_cast<uint64_t>(pc_views_block_id_[block_level.first]));
+	}
+}
+
+bool OctreeView::ShowBlock(
+		const size_t i,
+		const uint8_t* const payload_data,
+		const size_t payload_size,
+		size_t* const num_gpu_bytes
+		) {
+	const uint64_t hash = static_cast<uint64_t>(pc_views_block_id_[i]);
+	const point_records::Encoding encoding = octree_reader_.GetEncoding(pc_views_active_level_[i], hash);
+	std::vector<uint8_t> decompression_buffer;
+	const octree_reader::BlockSpan span = DecompressPayload(octree_reader_, pc_views_active_level_[i], hash, {payload_data, payload_size}, &decompression_buffer);
+	const uint8_t* const data = span.data;
+	const size_t size = span.size;
+	// unmapped or corrupt payloads, the converter writes no empty blocks
+	if(span.Empty() || size == 0 || size % point_records::RecordSize(encoding) != 0)
+		return false;
+	std::unique_ptr<std::vector<std::array<uint8_t, 4>>> colors(
+		new std::vector<std::array<uint8_t, 4>>);
+
+	// quantized blocks stay quantized on the gpu, 8 instead of 16 bytes per position.
+	// aligned blocks are copied to the gpu as they are, 16 bytes per point including the colour
+	if(encoding == point_records::Encoding::kXyzRgba) {
+		const size_t num_bytes = size / sizeof(point_records::XyzRgba) * sizeof(point_records::XyzRgba);
+		std::unique_ptr<std::vector<uint8_t>> points(new std::vector<uint8_t>(data, data + num_bytes));
+
+		*num_gpu_bytes = num_bytes;
+		pc_views_[i]->SetInterleavedPoints(std::move(points));
+	} else if(encoding == point_records::Encoding::kXyzRgbQuantized) {
+		std::unique_ptr<std::vector<std::array<uint16_t, 4>>> points(new std::vector<std::array<uint16_t, 4>>);
+		DecodeQuantizedPoints(data, size, points.get(), colors.get());
+
+		const std::array<float, 3> origin = octree_layout::BlockOrigin(hash);
+		*num_gpu_bytes = points->size() * (sizeof(std::array<uint16_t, 4>) + sizeof(std::array<uint8_t, 4>));
+		pc_views_[i]->SetQuantizedPoints(
+			std::move(points),
+			std::move(colors),
+			Eigen::Matrix<float, 3, 1>(origin[0], origin[1], origin[2]),
+			octree_layout::kLevel0CellSize
+			);
+	} else {
+		std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points(
+			new std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>());
+		DecodePoints(data, size, encoding, hash, points.get(), colors.get());
+
+		*num_gpu_bytes = points->size() * (sizeof(Eigen::Matrix<float, 4, 1>) + sizeof(std::array<uint8_t, 4>));
+		pc_views_[i]->SetPoints(
+			std::move(points),
+			std::move(colors)
+			);
+	}
+	pc_views_[i]->SetHidden(false);
+	pc_views_draw_level_0_[i] = false;
+	return true;
+}
+
+void OctreeView::RetryBlock(const size_t k) {
+	const size_t i = blocks_to_load_[k];
+	--num_blocks_per_level_[pc_views_active_level_[i]];
+	++num_blocks_per_level_[blocks_to_load_previous_level_[k]];
+	pc_views_active_level_[i] = blocks_to_load_previous_level_[k];
+	blocks_to_retry_.push_back(i);
+}
+
+/*
+note:
+const double constant = 1638570.0; // solve for 7
+const double constant = 409600.0; // solve for 6
+const double constant = 819200.0; // solve for 6.5
+*/
+
+// set constant such that it fulfills a boundary condition for the level computation
+// here we say that anything closer than 10m is full level 6 (so lvl 7)
+const double OctreeView::kLevelConstant = 1638570.0; 
+
+size_t OctreeView::ComputeDiscreteLevel(const double dist_squared) const {
+	const float level = static_cast<float>(0.7213475 * std::log(kLevelConstant / dist_squared) + resolution_adjustment_);
+	return (level < 0.0f ? 0 : std::min(static_cast<size_t>(level), static_cast<size_t>(6)));
+}
+
+float OctreeView::ComputeLevelBoundaryRadius(const size_t level) const {
+	// inverse of the level computation above
+	return static_cast<float>(std::sqrt(kLevelConstant * std::exp((static_cast<double>(resolution_adjustment_) - static_cast<double>(level)) / 0.7213475)));
+}
+
+void OctreeView::StartLevel0Loading(const Eigen::Matrix<float, 4, 1>& view_position) {
+	level_0_load_order_.resize(pc_views_block_id_.size());
+	std::iota(level_0_load_order_.begin(), level_0_load_order_.end(), 0);
+	std::sort(level_0_load_order_.begin(), level_0_load_order_.end(), [&](const size_t a, const size_t b) {
+		return (pc_views_centers_[a] - view_position).squaredNorm() < (pc_views_centers_[b] - view_position).squaredNorm();
+	});
+
+	const size_t num_threads = std::max(static_cast<size_t>(1), std::min(static_cast<size_t>(4), 
+		static_cast<size_t>(std::thread::hardware_concurrency())));
+	for(size_t t=0; t < num_threads; ++t)
+		level_0_load_threads_.emplace_back(new std::thread([&]() {
+			this->LoadLevel0();
+		}));
+}
+
+void OctreeView::LoadLevel0() {
+	std::vector<uint8_t> read_buffer;
+	std::vector<uint8_t> decompression_buffer;
+	while(!entered_class_destructor_) {
+		const size_t k = next_level_0_block_++;
+		if(k >= level_0_load_order_.size())
+			return;
+		const size_t i = level_0_load_order_[k];
+
+		// keep the OS busy a few blocks ahead of the loading threads
+		const size_t prefetch_distance = 16;
+		if(k + prefetch_distance < level_0_load_order_.size())
+			octree_reader_.Prefetch(0, static_cast<uint64_t>(pc_views_block_id_[level_0_load_order_[k + prefetch_distance]]));
+
+		std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points(
+			new std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>());
+		std::unique_ptr<std::vector<std::array<uint8_t, 4>>> colors(
+			new std::vector<std::array<uint8_t, 4>>);
+
+		ReadPoints(
+			octree_reader_,
+			0,
+			static_cast<uint64_t>(pc_views_block_id_[i]),
+			&read_buffer,
+			&decompression_buffer,
+			points.get(),
+			colors.get()
+			);
+
+		const GLsizei count = static_cast<GLsizei>(points->size());
+		const GLint first = pc_level_0_->AppendPoints(std::move(points), std::move(colors));
+		if(first >= 0) {
+			pc_views_level_0_range_[i] = {first, count};
+			pc_views_level_0_loaded_[i] = true;
 		}
+		++num_level_0_blocks_loaded_;
 	}
 }
 
+float OctreeView::GetLoadingProgress() const {
+	if(pc_views_block_id_.empty())
+		return IsInitialized() ? 1.0f : 0.0f;
+	return static_cast<float>(num_level_0_blocks_loaded_) / static_cast<float>(pc_views_block_id_.size());
+}
+
 OctreeView::~OctreeView() {
 	entered_class_destructor_ = true;
-	octree_load_thread_->join();
+	for(std::unique_ptr<std::thread>& thread : level_0_load_threads_)
+		thread->join();
+	if(octree_load_thread_ != nullptr)
+		octree_load_thread_->join();
 }
 
 size_t OctreeView::GetLowestLevel() const {
-	size_t max_level = 0;
-	for(const size_t i : pc_views_active_level_)
-		max_level = std::max(max_level, i);
-	return max_level;
+	for(size_t level = num_blocks_per_level_.size() - 1; level > 0; --level)
+		if(num_blocks_per_level_[level] > 0)
+			return level;
+	return 0;
+}
+
+GpuResidency::Counters OctreeView::GetResidencyCounters() const {
+	if(residency_ == nullptr)
+		return GpuResidency::Counters();
+	return residency_->GetCounters();
 }
 
 float OctreeView::ComputeResolutionAdjustment(const size_t num_pixels) {
@@ -4,13 +4,20 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <array>
 
 #include <Eigen/Core>
 #include <Eigen/StdVector>
 
 #include <Gui/Views/ViewBase.h>
 #include <Gui/Views/PointCloudView/PointCloudView.h>
+#include <Gui/Views/OctreeView/GpuResidency.h>
+#include <Gui/Views/OctreeView/BlockGrid.h>
 #include <FileIO/OctreeReader.h>
+#include <FileIO/AsyncReader.h>
 
 namespace gui {
 
@@ -26,14 +33,20 @@ public:
 	/// Voxel size referes to level 0 voxel size.
 	/// rendered within a lod-voxel to make smoother lod transitions. 
 	/// Allows the definition of screen resolution adjustment of the LOD.
+	/// Detail buffers of hidden blocks are evicted once they exceed the gpu memory budget.
+	/// Block reads that are at most the coalescing gap apart in the file are merged into one read.
 	///
 	OctreeView(
 		const octree_reader::OctreeReader& octree_reader,
 		const size_t num_pixels = 1920 * 1080,
-		const float voxel_size = 10.0f
+		const float voxel_size = 10.0f,
+		const size_t gpu_memory_budget = 1024ull * 1024ull * 1024ull,
+		const size_t read_coalescing_gap = 64 * 1024
 		) : octree_reader_(octree_reader),
 			voxel_size_(voxel_size),
-			resolution_adjustment_(ComputeResolutionAdjustment(num_pixels)) {
+			resolution_adjustment_(ComputeResolutionAdjustment(num_pixels)),
+			gpu_memory_budget_(gpu_memory_budget),
+			read_coalescing_gap_(read_coalescing_gap) {
 			};
 
 	///
@@ -61,30 +74,120 @@ public:
 	///
 	size_t GetLowestLevel() const;
 
+	///
+	/// Returns the statistics of the gpu buffer residency of the detail views.
+	///
+	GpuResidency::Counters GetResidencyCounters() const;
+
+	///
+	/// Returns the fraction of level 0 blocks that are loaded, in [0, 1].
+	///
+	float GetLoadingProgress() const;
+
 private:
 	///
 	/// Function designed to run in its own thread.
 	///
 	void LoadOctree();
 
+	///
+	/// Starts the threads that stream the level 0 blocks into the shared buffer.
+	/// Blocks closest to the given view position are loaded first.
+	///
+	void StartLevel0Loading(const Eigen::Matrix<float, 4, 1>& view_position);
+
+	///
+	/// Function designed to run in the level 0 loading threads.
+	///
+	void LoadLevel0();
+
+	///
+	/// Decompresses and decodes the payload of a block at its active level and hands it to the detail view of the block.
+	/// Sets the gpu memory the block will take. Can run concurrently for different blocks,
+	/// the caller reports the upload to the residency.
+	/// Returns false and leaves the view of the block untouched if the payload is missing or corrupt.
+	///
+	bool ShowBlock(
+		const size_t i,
+		const uint8_t* const payload_data,
+		const size_t payload_size,
+		size_t* const num_gpu_bytes
+		);
+
+	///
+	/// Undoes the level change of the k-th block to load after its read or decode failed.
+	/// The block keeps showing what it showed before and is evaluated again on the next update.
+	///
+	void RetryBlock(const size_t k);
+
 	///
 	/// Compues the resolution adjustment for the level switching
 	///
 	static float ComputeResolutionAdjustment(const size_t num_pixels); 
 
+	///
+	/// Level of detail of a block at the given squared distance to the viewer.
+	///
+	size_t ComputeDiscreteLevel(const double dist_squared) const;
+
+	///
+	/// Distance to the viewer below which blocks are at least at the given level.
+	///
+	float ComputeLevelBoundaryRadius(const size_t level) const;
+
 private:
     const octree_reader::OctreeReader& octree_reader_;
 	const float voxel_size_;
 	const float resolution_adjustment_;
+	const size_t gpu_memory_budget_;
+	const size_t read_coalescing_gap_;
 	std::vector<std::unique_ptr<PointCloudView>> pc_views_;
 	std::vector<size_t> pc_views_active_level_;
 	std::vector<int64_t> pc_views_block_id_;
 	std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>> pc_views_centers_;
+
+	// level 0 points of all blocks in a single buffer, every block owns a (first, count) range of it
 	std::unique_ptr<PointCloudView> pc_level_0_;
+	std::vector<std::pair<GLint, GLsizei>> pc_views_level_0_range_;
+	std::unique_ptr<std::atomic<bool>[]> pc_views_draw_level_0_;
+	std::unique_ptr<std::atomic<bool>[]> pc_views_level_0_loaded_;
+	std::vector<std::pair<GLint, GLsizei>> level_0_draw_ranges_;
+
+	// level evaluation, only touched by the loading thread except for the level counts
+	static const double kLevelConstant;
+	std::unique_ptr<BlockGrid> block_grid_;
+	std::array<float, 7> level_boundary_radius_ = {{0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
+	std::array<std::atomic<size_t>, 7> num_blocks_per_level_ = {{{0}, {0}, {0}, {0}, {0}, {0}, {0}}};
+	std::vector<size_t> level_candidates_;
+	std::vector<uint32_t> level_candidates_stamps_;
+	uint32_t level_candidates_stamp_ = 0;
+	Eigen::Matrix<float, 4, 1> last_evaluated_position_ = Eigen::Matrix<float, 4, 1>::Zero();
+	bool evaluated_once_ = false;
+
+	// gpu memory of the detail views, only touched by the loading thread
+	std::unique_ptr<GpuResidency> residency_;
+
+	// reads of the detail levels, only touched by the loading thread
+	std::unique_ptr<async_io::AsyncReader> block_reader_;
+	std::vector<size_t> blocks_to_load_;
+	// level of the blocks to load before the request, restored if their read fails
+	std::vector<size_t> blocks_to_load_previous_level_;
+	// blocks whose read or decode failed, evaluated again on the next update
+	std::vector<size_t> blocks_to_retry_;
+	std::vector<std::vector<uint8_t>> block_buffers_;
+	std::vector<async_io::ReadRequest> block_read_requests_;
+	std::vector<async_io::ReadCompletion> block_read_completions_;
+	std::vector<size_t> block_gpu_bytes_;
+	// per block to load whether it was shown, bytes instead of bools so the decode threads can set them concurrently
+	std::vector<uint8_t> block_shown_;
 
 	// variables handling the octree loading work
 	std::unique_ptr<std::thread> octree_load_thread_;
-	bool entered_class_destructor_ = false;
+	std::vector<std::unique_ptr<std::thread>> level_0_load_threads_;
+	std::vector<size_t> level_0_load_order_;
+	std::atomic<size_t> next_level_0_block_{0};
+	std::atomic<size_t> num_level_0_blocks_loaded_{0};
+	std::atomic<bool> entered_class_destructor_{false};
 	bool new_view_position_available_ = false;
 	Eigen::Matrix<float, 4, 1> view_position_;
 };
@@ -80,6 +80,8 @@ void PointCloudView::Init() {
     gl_index_proj_ = glGetUniformLocation(shader_->Id(), "proj_");
     gl_index_point_size_ = glGetUniformLocation(shader_->Id(), "point_size_");
     gl_index_alpha_ = glGetUniformLocation(shader_->Id(), "alpha_");
+    gl_index_xyz_offset_ = glGetUniformLocation(shader_->Id(), "xyz_offset_");
+    gl_index_xyz_scale_ = glGetUniformLocation(shader_->Id(), "xyz_scale_");
 
     shader_->Use();
     glGenBuffers(1, &gl_points_buffer_);
@@ -95,19 +97,63 @@ void PointCloudView::Draw(
     const Eigen::Matrix<float, 4, 4>& projection,
     const Eigen::Matrix<float, 4, 4>& w2v_tf
     ) {
+    if (!IsInitialized())
+        return;
+    if(!UpdateBuffers())
+        return;
     if(IsHidden())
         return;
+
+    BeginDraw(projection, w2v_tf);
+    
+    if(render_percentage_ == 1.0f) {
+        glDrawArrays(GL_POINTS, 0, num_points_);
+    } else {
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(render_percentage_ * static_cast<float>(num_points_) + 1.01f));
+    }
+
+    EndDraw();
+}
+
+void PointCloudView::DrawRanges(
+    const Eigen::Matrix<float, 4, 4>& projection,
+    const Eigen::Matrix<float, 4, 4>& w2v_tf,
+    const std::vector<std::pair<GLint, GLsizei>>& ranges
+    ) {
     if (!IsInitialized())
         return;
-    if(num_points_ == 0 && next_points_ == nullptr)
+    if(!UpdateBuffers())
+        return;
+    if(IsHidden() || ranges.empty())
         return;
 
-    shader_->Use();
+    BeginDraw(projection, w2v_tf);
 
-    glUniformMatrix4fv(gl_index_w2v_, 1, GL_FALSE, w2v_tf.data());
-    glUniformMatrix4fv(gl_index_proj_, 1, GL_FALSE, projection.data());
-    glUniform1f(gl_index_point_size_, point_size_);
-    glUniform1f(gl_index_alpha_, this->GetAlpha());
+    for(const std::pair<GLint, GLsizei>& range : ranges) {
+        if(range.first + range.second > num_points_)
+            continue;
+        glDrawArrays(GL_POINTS, range.first, range.second);
+    }
+
+    EndDraw();
+}
+
+bool PointCloudView::UpdateBuffers() {
+    if(!buffers_dirty_.load(std::memory_order_acquire))
+        return num_points_ > 0;
+
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    buffers_dirty_.store(false, std::memory_order_relaxed);
+
+    if(release_pending_) {
+        // orphan the storage so the driver can give the memory back
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+        num_points_ = 0;
+        release_pending_ = false;
+    }
 
     if(next_points_ != nullptr && next_rgba_!= nullptr
         && next_points_->size() == next_rgba_->size()) {
@@ -127,24 +173,131 @@ void PointCloudView::Draw(
             );
 
         num_points_ = static_cast<GLsizei>(next_points_->size());
+        quantized_ = false;
+        interleaved_ = false;
+        xyz_offset_.setZero();
+        xyz_scale_ = 1.0f;
         next_points_.reset(nullptr);
         next_rgba_.reset(nullptr);
     }
 
+    if(next_quantized_points_ != nullptr && next_rgba_ != nullptr
+        && next_quantized_points_->size() == next_rgba_->size()) {
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glBufferData(
+            GL_ARRAY_BUFFER, 
+            static_cast<GLsizeiptr>(next_quantized_points_->size() * 4 * sizeof(uint16_t)), 
+            next_quantized_points_->data(), 
+            GL_STREAM_DRAW
+            );
+        glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
+        glBufferData(
+            GL_ARRAY_BUFFER, 
+            static_cast<GLsizeiptr>(next_rgba_->size() * 4 * sizeof(uint8_t)), 
+            next_rgba_->data(), 
+            GL_STREAM_DRAW
+            );
+
+        num_points_ = static_cast<GLsizei>(next_quantized_points_->size());
+        quantized_ = true;
+        interleaved_ = false;
+        xyz_offset_ = next_origin_;
+        xyz_scale_ = next_extent_;
+        next_quantized_points_.reset(nullptr);
+        next_rgba_.reset(nullptr);
+    }
+
+    if(next_interleaved_points_ != nullptr) {
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glBufferData(
+            GL_ARRAY_BUFFER, 
+            static_cast<GLsizeiptr>(next_interleaved_points_->size()), 
+            next_interleaved_points_->data(), 
+            GL_STREAM_DRAW
+            );
+        glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+
+        num_points_ = static_cast<GLsizei>(next_interleaved_points_->size() / static_cast<size_t>(kInterleavedStride));
+        quantized_ = false;
+        interleaved_ = true;
+        xyz_offset_.setZero();
+        xyz_scale_ = 1.0f;
+        next_interleaved_points_.reset(nullptr);
+    }
+
+    if(reserve_pending_ > 0) {
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(reserve_pending_ * 4 * sizeof(float)), nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(reserve_pending_ * 4 * sizeof(uint8_t)), nullptr, GL_STATIC_DRAW);
+        num_points_ = 0;
+        quantized_ = false;
+        interleaved_ = false;
+        xyz_offset_.setZero();
+        xyz_scale_ = 1.0f;
+        reserve_pending_ = 0;
+    }
+
+    for(const auto& append : pending_appends_) {
+        const size_t first = static_cast<size_t>(num_points_);
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glBufferSubData(
+            GL_ARRAY_BUFFER,
+            static_cast<GLintptr>(first * 4 * sizeof(float)),
+            static_cast<GLsizeiptr>(append.first->size() * 4 * sizeof(float)),
+            &(append.first->at(0)(0))
+            );
+        glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
+        glBufferSubData(
+            GL_ARRAY_BUFFER,
+            static_cast<GLintptr>(first * 4 * sizeof(uint8_t)),
+            static_cast<GLsizeiptr>(append.second->size() * 4 * sizeof(uint8_t)),
+            &(append.second->at(0))
+            );
+        num_points_ += static_cast<GLsizei>(append.first->size());
+    }
+    pending_appends_.clear();
+
+    return num_points_ > 0;
+}
+
+void PointCloudView::BeginDraw(
+    const Eigen::Matrix<float, 4, 4>& projection,
+    const Eigen::Matrix<float, 4, 4>& w2v_tf
+    ) {
+    shader_->Use();
+
+    glUniformMatrix4fv(gl_index_w2v_, 1, GL_FALSE, w2v_tf.data());
+    glUniformMatrix4fv(gl_index_proj_, 1, GL_FALSE, projection.data());
+    glUniform1f(gl_index_point_size_, point_size_);
+    glUniform1f(gl_index_alpha_, this->GetAlpha());
+    glUniform3f(gl_index_xyz_offset_, xyz_offset_(0), xyz_offset_(1), xyz_offset_(2));
+    glUniform1f(gl_index_xyz_scale_, xyz_scale_);
+
+    if(interleaved_) {
+        // w of xyz1_ defaults to 1 when only xyz is bound
+        glEnableVertexAttribArray(gl_index_xyz1_);
+        glEnableVertexAttribArray(gl_index_rgba_);
+        glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
+        glVertexAttribPointer(gl_index_xyz1_, 3, GL_FLOAT, GL_FALSE, kInterleavedStride, 0);
+        glVertexAttribPointer(gl_index_rgba_, 4, GL_UNSIGNED_BYTE, GL_FALSE, kInterleavedStride, reinterpret_cast<const void*>(3 * sizeof(float)));
+        return;
+    }
+
     glEnableVertexAttribArray(gl_index_xyz1_);
     glBindBuffer(GL_ARRAY_BUFFER, gl_points_buffer_);
-    glVertexAttribPointer(gl_index_xyz1_, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    if(quantized_)
+        glVertexAttribPointer(gl_index_xyz1_, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0, 0);
+    else
+        glVertexAttribPointer(gl_index_xyz1_, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
     glEnableVertexAttribArray(gl_index_rgba_);
     glBindBuffer(GL_ARRAY_BUFFER, gl_rgba_buffer_);
     glVertexAttribPointer(gl_index_rgba_, 4, GL_UNSIGNED_BYTE, GL_FALSE, 0, 0);
-    
-    if(render_percentage_ == 1.0f) {
-        glDrawArrays(GL_POINTS, 0, num_points_);
-    } else {
-        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(render_percentage_ * static_cast<float>(num_points_) + 1.01f));
-    }
+}
 
+void PointCloudView::EndDraw() {
     glDisableVertexAttribArray(gl_index_xyz1_);
     glDisableVertexAttribArray(gl_index_rgba_);
 }
@@ -158,8 +311,108 @@ void PointCloudView::SetPoints(
     if(points->size() == 0)
         return;
     
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
     next_points_ = std::move(points);
     next_rgba_ = std::move(point_rgba);
+    next_quantized_points_.reset(nullptr);
+    next_interleaved_points_.reset(nullptr);
+    pending_appends_.clear();
+    reserve_pending_ = 0;
+    num_points_reserved_ = 0;
+    num_points_appended_ = 0;
+    release_pending_ = false;
+    buffers_dirty_.store(true, std::memory_order_release);
+}
+
+void PointCloudView::SetQuantizedPoints(
+    std::unique_ptr<std::vector<std::array<uint16_t, 4>>> points,
+    std::unique_ptr<std::vector<std::array<uint8_t, 4>>> point_rgba,
+    const Eigen::Matrix<float, 3, 1>& origin,
+    const float extent
+    ) {
+    if(points->size() != point_rgba->size())
+        return;
+    if(points->size() == 0)
+        return;
+    
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    next_quantized_points_ = std::move(points);
+    next_rgba_ = std::move(point_rgba);
+    next_origin_ = origin;
+    next_extent_ = extent;
+    next_points_.reset(nullptr);
+    next_interleaved_points_.reset(nullptr);
+    pending_appends_.clear();
+    reserve_pending_ = 0;
+    num_points_reserved_ = 0;
+    num_points_appended_ = 0;
+    release_pending_ = false;
+    buffers_dirty_.store(true, std::memory_order_release);
+}
+
+void PointCloudView::SetInterleavedPoints(std::unique_ptr<std::vector<uint8_t>> points) {
+    if(points->size() < static_cast<size_t>(kInterleavedStride))
+        return;
+    
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    next_interleaved_points_ = std::move(points);
+    next_points_.reset(nullptr);
+    next_rgba_.reset(nullptr);
+    next_quantized_points_.reset(nullptr);
+    pending_appends_.clear();
+    reserve_pending_ = 0;
+    num_points_reserved_ = 0;
+    num_points_appended_ = 0;
+    release_pending_ = false;
+    buffers_dirty_.store(true, std::memory_order_release);
+}
+
+void PointCloudView::Reserve(const size_t num_points) {
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    next_points_.reset(nullptr);
+    next_rgba_.reset(nullptr);
+    next_quantized_points_.reset(nullptr);
+    next_interleaved_points_.reset(nullptr);
+    pending_appends_.clear();
+    reserve_pending_ = num_points;
+    num_points_reserved_ = num_points;
+    num_points_appended_ = 0;
+    release_pending_ = false;
+    buffers_dirty_.store(true, std::memory_order_release);
+}
+
+GLint PointCloudView::AppendPoints(
+    std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points,
+    std::unique_ptr<std::vector<std::array<uint8_t, 4>>> point_rgba
+    ) {
+    if(points->size() != point_rgba->size())
+        return -1;
+
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    if(num_points_appended_ + points->size() > num_points_reserved_)
+        return -1;
+
+    const GLint first = static_cast<GLint>(num_points_appended_);
+    if(points->empty())
+        return first;
+
+    num_points_appended_ += points->size();
+    pending_appends_.push_back({std::move(points), std::move(point_rgba)});
+    buffers_dirty_.store(true, std::memory_order_release);
+    return first;
+}
+
+void PointCloudView::ClearPoints() {
+    std::lock_guard<std::mutex> lock(next_points_mutex_);
+    next_points_.reset(nullptr);
+    next_rgba_.reset(nullptr);
+    next_quantized_points_.reset(nullptr);
+    next_interleaved_points_.reset(nullptr);
+    pending_appends_.clear();
+    num_points_reserved_ = 0;
+    num_points_appended_ = 0;
+    release_pending_ = true;
+    buffers_dirty_.store(true, std::memory_order_release);
 }
 
 void PointCloudView::SetPointSize(const float point_size) {
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
 
 #include <Gui/Views/ViewBase.h>
 #include <Gui/Views/ShaderWrapper.h>
@@ -22,6 +26,16 @@ public:
 		const Eigen::Matrix<float, 4, 4>& w2v_tf
 		) final override;
 
+	///
+	/// Draws only the given (first index, count) ranges of the uploaded points.
+	/// Used when several blocks share one buffer.
+	///
+	void DrawRanges(
+		const Eigen::Matrix<float, 4, 4>& projection,
+		const Eigen::Matrix<float, 4, 4>& w2v_tf,
+		const std::vector<std::pair<GLint, GLsizei>>& ranges
+		);
+
 	///
 	/// Sets points for this view. Points are copied into gpu on next draw call.
 	///
@@ -30,6 +44,46 @@ public:
 		std::unique_ptr<std::vector<std::array<uint8_t, 4>>> point_rgba
 		);
 
+	///
+	/// Sets quantized points for this view. Points are copied into gpu on next draw call.
+	/// xyz are fixed-point offsets in [0, 65535] from origin, 65535 corresponds to extent. The fourth component is unused.
+	/// The points stay 8 bytes on the gpu and are dequantized in the vertex shader.
+	///
+	void SetQuantizedPoints(
+		std::unique_ptr<std::vector<std::array<uint16_t, 4>>> points,
+		std::unique_ptr<std::vector<std::array<uint8_t, 4>>> point_rgba,
+		const Eigen::Matrix<float, 3, 1>& origin,
+		const float extent
+		);
+
+	///
+	/// Sets interleaved points for this view. Points are copied into gpu on next draw call.
+	/// Every point is 16 bytes, 3 floats for xyz followed by 4 bytes rgba, and goes to the gpu as it is.
+	///
+	void SetInterleavedPoints(std::unique_ptr<std::vector<uint8_t>> points);
+
+	///
+	/// Allocates gpu storage for the given number of points on the next draw call.
+	/// Points are then added with AppendPoints. Discards the current content.
+	///
+	void Reserve(const size_t num_points);
+
+	///
+	/// Queues points to be copied behind the already appended ones on the next draw call.
+	/// Returns the index of the first appended point in the buffer or -1 if the reserved space is exceeded.
+	/// Can be called from a thread other than the render thread.
+	///
+	GLint AppendPoints(
+		std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> points,
+		std::unique_ptr<std::vector<std::array<uint8_t, 4>>> point_rgba
+		);
+
+	///
+	/// Drops pending points and releases the gpu storage on the next draw call.
+	/// Can be called from a thread other than the render thread.
+	///
+	void ClearPoints();
+
 	///
 	/// Sets point size for this view.
 	///
@@ -47,6 +101,25 @@ private:
 	///
 	virtual void Init() final override;
 
+	///
+	/// Uploads pending points or releases the buffers if requested.
+	/// Only locks the mutex if a setter ran since the last call. Returns false if there is nothing to draw.
+	///
+	bool UpdateBuffers();
+
+	///
+	/// Binds buffers and uniforms for the draw calls.
+	///
+	void BeginDraw(
+		const Eigen::Matrix<float, 4, 4>& projection,
+		const Eigen::Matrix<float, 4, 4>& w2v_tf
+		);
+
+	///
+	/// Unbinds what BeginDraw has bound.
+	///
+	void EndDraw();
+
 
 private:
 	static std::unique_ptr<ShaderWrapper> shader_;
@@ -56,12 +129,36 @@ private:
 	GLint gl_index_proj_;
 	GLint gl_index_point_size_;
 	GLint gl_index_alpha_;
+	GLint gl_index_xyz_offset_;
+	GLint gl_index_xyz_scale_;
 	GLuint gl_points_buffer_;
 	GLuint gl_rgba_buffer_;
+	static constexpr GLsizei kInterleavedStride = 3 * sizeof(float) + 4 * sizeof(uint8_t);
 
 	GLsizei num_points_= 0;
 	std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>> next_points_;
 	std::unique_ptr<std::vector<std::array<uint8_t, 4>>> next_rgba_;
+	std::unique_ptr<std::vector<std::array<uint16_t, 4>>> next_quantized_points_;
+	std::unique_ptr<std::vector<uint8_t>> next_interleaved_points_;
+	Eigen::Matrix<float, 3, 1> next_origin_ = Eigen::Matrix<float, 3, 1>::Zero();
+	float next_extent_ = 1.0f;
+	bool release_pending_ = false;
+	size_t reserve_pending_ = 0;
+	size_t num_points_reserved_ = 0;
+	size_t num_points_appended_ = 0;
+	std::vector<std::pair<
+		std::unique_ptr<std::vector<Eigen::Matrix<float, 4, 1>, Eigen::aligned_allocator<Eigen::Matrix<float, 4, 1>>>>,
+		std::unique_ptr<std::vector<std::array<uint8_t, 4>>>>> pending_appends_;
+	std::mutex next_points_mutex_;
+	// set by the setters under the mutex, so draw calls of views without pending changes do not lock it
+	std::atomic<bool> buffers_dirty_{false};
+
+	// dequantization of the uploaded points, zero offset and unit scale for float points
+	bool quantized_ = false;
+	// xyz and rgba share the points buffer
+	bool interleaved_ = false;
+	Eigen::Matrix<float, 3, 1> xyz_offset_ = Eigen::Matrix<float, 3, 1>::Zero();
+	float xyz_scale_ = 1.0f;
 
 	float point_size_ = 1.0f;
 	float render_percentage_ = 1.0f;
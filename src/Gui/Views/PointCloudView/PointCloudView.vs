@@ -6,11 +6,14 @@ attribute vec4 rgba_;
 uniform mat4 w2v_;
 uniform mat4 proj_;
 uniform float point_size_;
+uniform vec3 xyz_offset_;
+uniform float xyz_scale_;
 
 varying vec4 v_rgba_;
 
 void main() {
     gl_PointSize = point_size_; 
-    gl_Position = proj_ * w2v_ * xyz1_;
+    // quantized points arrive normalized to [0, 1] and are scaled back into their cell, float points pass unchanged
+    gl_Position = proj_ * w2v_ * vec4(xyz_offset_ + xyz_scale_ * xyz1_.xyz, 1.0);
     v_rgba_ = rgba_;
 }
@@ -1,19 +1,25 @@
 #include "Window.h"
 
 #include <iomanip>
+#include <sstream>
 #include <filesystem>
 
 #include <QGridLayout>
 #include <QKeyEvent>
 #include <QApplication>
 #include <QDesktopWidget>
+#include <QStatusBar>
 
 
 namespace gui {
 	
 template <typename T>
-Window<T>::Window(const octree_reader::OctreeReader& octree_reader) : octree_reader_(octree_reader),
-        opengl_widget_(octree_reader) {
+Window<T>::Window(
+        const octree_reader::OctreeReader& octree_reader,
+        const size_t gpu_memory_budget,
+        const size_t read_coalescing_gap
+        ) : octree_reader_(octree_reader),
+        opengl_widget_(octree_reader, gpu_memory_budget, read_coalescing_gap) {
             
     opengl_widget_.installEventFilter(this);
 
@@ -30,6 +36,23 @@ Window<T>::Window(const octree_reader::OctreeReader& octree_reader) : octree_rea
     main_widget_.setLayout(layout);
 
     setCentralWidget(&main_widget_);
+
+    // the octree streams in after the window is shown
+    loading_progress_bar_.setRange(0, 100);
+    loading_progress_bar_.setFormat("Loading octree %p%");
+    loading_progress_bar_.setMaximumWidth(300);
+    statusBar()->addPermanentWidget(&loading_progress_bar_);
+    QObject::connect(&loading_progress_timer_, &QTimer::timeout, [this]() {
+        UpdateLoadingProgress();
+    });
+    loading_progress_timer_.start(100);
+
+    // the eviction policy is observable while moving through the octree
+    statusBar()->addWidget(&residency_label_);
+    QObject::connect(&residency_timer_, &QTimer::timeout, [this]() {
+        UpdateResidencyCounters();
+    });
+    residency_timer_.start(500);
 }
 
 template <typename T>
@@ -68,6 +91,31 @@ bool Window<T>::ProcessKeyPress(const QKeyEvent* const event) {
     }
 }
 
+template <typename T>
+void Window<T>::UpdateLoadingProgress() {
+    const float progress = opengl_widget_.GetLoadingProgress();
+    loading_progress_bar_.setValue(static_cast<int>(100.0f * progress));
+
+    if(progress >= 1.0f) {
+        loading_progress_timer_.stop();
+        statusBar()->removeWidget(&loading_progress_bar_);
+    }
+}
+
+template <typename T>
+void Window<T>::UpdateResidencyCounters() {
+    const GpuResidency::Counters counters = opengl_widget_.GetResidencyCounters();
+    const size_t mb = 1024 * 1024;
+    std::ostringstream text;
+    text << "GPU " << counters.resident_bytes / mb << " / " << counters.budget_bytes / mb << " MB"
+        << " (peak " << counters.peak_resident_bytes / mb << " MB), "
+        << counters.num_resident_blocks << " blocks resident, "
+        << counters.num_uploads << " uploads, "
+        << counters.num_cache_hits << " cache hits, "
+        << counters.num_evictions << " evictions (" << counters.evicted_bytes / mb << " MB)";
+    residency_label_.setText(QString::fromStdString(text.str()));
+}
+
 template <typename T>
 bool Window<T>::eventFilter(QObject* const obj, QEvent* const event)
 {
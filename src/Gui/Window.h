@@ -6,6 +6,8 @@
 
 #include <QMainWindow>
 #include <QLabel> 
+#include <QProgressBar>
+#include <QTimer>
 #include <Eigen/Core>
 
 #include <Gui/OpenGlWidget.h>
@@ -28,8 +30,13 @@ class Window final : public QMainWindow {
 public:
     ///
     /// Constructor with reference to an octree reader instance.
+    /// The gpu memory budget and the read coalescing gap are passed on to the octree view.
     ///
-    Window(const octree_reader::OctreeReader& octree_reader);
+    Window(
+        const octree_reader::OctreeReader& octree_reader,
+        const size_t gpu_memory_budget,
+        const size_t read_coalescing_gap
+        );
     
     ///
     ///  Virtual destructor.
@@ -42,6 +49,16 @@ private:
     /// 
     bool ProcessKeyPress(const QKeyEvent* const event);
 
+    ///
+    /// Polled by the progress timer, shows the loading progress in the status bar until done.
+    ///
+    void UpdateLoadingProgress();
+
+    ///
+    /// Polled by the residency timer, shows the gpu memory use and the uploads and evictions of the detail levels.
+    ///
+    void UpdateResidencyCounters();
+
 private:
     ///
     /// Overrides key press event in order to be able to move the camera arround in space.
@@ -63,6 +80,11 @@ private:
     
     QWidget main_widget_;
     OpenGlWidget<T> opengl_widget_;
+
+    QProgressBar loading_progress_bar_;
+    QTimer loading_progress_timer_;
+    QLabel residency_label_;
+    QTimer residency_timer_;
 };
 
 } // namespace gui
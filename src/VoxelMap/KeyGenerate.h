@@ -21,21 +21,16 @@ public:
 	}
 
 	int64_t GetVoxelId(const Eigen::Matrix<T, 4, 1>& xyz) const {
-		const std::array<int64_t, 3> ijk = GetVoxelPosition(xyz);
-		const int64_t i = ijk[0];
-		const int64_t j = ijk[1];
-		const int64_t k = ijk[2];
+		return GetVoxelId(xyz(0), xyz(1), xyz(2));
+	}
 
-		return GetVoxelId(i, j, k);
+	int64_t GetVoxelId(const T x, const T y, const T z) const {
+		return GetVoxelId(GetVoxelIndex(x), GetVoxelIndex(y), GetVoxelIndex(z));
 	}
 
 private:
-	std::array<int64_t, 3> GetVoxelPosition(const Eigen::Matrix<T, 4, 1>& xyz) const {
-		return {
-			static_cast<int64_t>(xyz(0) * inverse_voxel_size_) + (xyz(0) < static_cast<T>(0.0) ? -1 : 0),
-			static_cast<int64_t>(xyz(1) * inverse_voxel_size_) + (xyz(1) < static_cast<T>(0.0) ? -1 : 0),
-			static_cast<int64_t>(xyz(2) * inverse_voxel_size_) + (xyz(2) < static_cast<T>(0.0) ? -1 : 0)
-		};
+	int64_t GetVoxelIndex(const T coordinate) const {
+		return static_cast<int64_t>(coordinate * inverse_voxel_size_) + (coordinate < static_cast<T>(0.0) ? -1 : 0);
 	}
 
 private:
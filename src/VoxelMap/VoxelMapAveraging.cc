@@ -2,6 +2,20 @@
 
 #include <omp.h>
 
+namespace {
+
+template <typename T>
+size_t NumPoints(const std::vector<geometry::Point<T>>& points) {
+	return points.size();
+}
+
+template <typename T>
+size_t NumPoints(const geometry::PointCloud<T>& points) {
+	return points.Size();
+}
+
+} // namespace
+
 namespace voxel_map {
 
 template <typename T>
@@ -51,8 +65,40 @@ VoxelMapAveraging<T>::VoxelMapAveraging(
 }
 
 template <typename T>
-void VoxelMapAveraging<T>::GenerateSubMaps(
+typename VoxelMapAveraging<T>::VoxelAvg VoxelMapAveraging<T>::MakeSample(
 	const std::vector<geometry::Point<T>>& points,
+	const size_t i,
+	const T weight
+	) {
+	return VoxelAvg(
+		points[i].xyz_.template block<3,1>(0,0), 
+		{
+			static_cast<T>(points[i].c_[0]),
+			static_cast<T>(points[i].c_[1]),
+			static_cast<T>(points[i].c_[2])
+		},
+		weight
+		);
+}
+
+template <typename T>
+typename VoxelMapAveraging<T>::VoxelAvg VoxelMapAveraging<T>::MakeSample(
+	const geometry::PointCloud<T>& points,
+	const size_t i,
+	const T weight
+	) {
+	Eigen::Matrix<T, 3, 1> rgb = Eigen::Matrix<T, 3, 1>::Zero();
+	if(points.HasColors()) {
+		const std::array<uint8_t, 3>& color = points.Colors()[i];
+		rgb << static_cast<T>(color[0]), static_cast<T>(color[1]), static_cast<T>(color[2]);
+	}
+	return VoxelAvg(points.Xyz(i), rgb, weight);
+}
+
+template <typename T>
+template <typename Points>
+void VoxelMapAveraging<T>::GenerateSubMaps(
+	const Points& points,
 	const std::vector<T>& weights,
 	const T voxel_size,
 	const int64_t hash_range,
@@ -66,20 +112,13 @@ void VoxelMapAveraging<T>::GenerateSubMaps(
 
 	bool insertion_loop_corrupt = false;
 	
+	const size_t num_points = NumPoints(points);
 	#pragma omp parallel for schedule(dynamic)
-	for(size_t i=0; i < points.size(); ++i) {
+	for(size_t i=0; i < num_points; ++i) {
 		if(insertion_loop_corrupt)
 			continue;
 
-		const VoxelAvg xyzn_sample(
-			points[i].xyz_.template block<3,1>(0,0), 
-			{
-				static_cast<T>(points[i].c_[0]),
-				static_cast<T>(points[i].c_[1]),
-				static_cast<T>(points[i].c_[2])
-			},
-			(weights.empty() ? static_cast<T>(1.0) : weights[i])
-			);
+		const VoxelAvg xyzn_sample = MakeSample(points, i, (weights.empty() ? static_cast<T>(1.0) : weights[i]));
 		const bool ret = voxel_map_instances->at(static_cast<size_t>(omp_get_thread_num())).Insert(xyzn_sample);
 		if(!ret)
 			insertion_loop_corrupt = true;
@@ -110,6 +149,18 @@ bool VoxelMapAveraging<T>::AddSamples(
 	return true;
 }
 
+template <typename T>
+bool VoxelMapAveraging<T>::AddSamples(
+	const geometry::PointCloud<T>& points,
+	const std::vector<T>& weights
+	) {
+	std::vector<VoxelMapAbstract<T, VoxelAvg>> voxel_map_instances;
+	GenerateSubMaps(points, weights, voxel_size_, hash_range_, &voxel_map_instances);
+	MergeSubMaps(voxel_map_instances, voxel_map_.get());
+
+	return true;
+}
+
 template <typename T>
 void VoxelMapAveraging<T>::RemoveSamples(
 	const std::vector<geometry::Point<T>>& points,
@@ -5,6 +5,7 @@
 
 #include <VoxelMap/VoxelMapAbstract.h>
 #include <Geometry/Point.h>
+#include <Geometry/PointCloud.h>
 
 namespace voxel_map {
 
@@ -89,6 +90,14 @@ public:
 		const std::vector<T>& weights = {}
 		);
 
+	///
+	/// Same as above for a structure of arrays cloud. Points without colors are inserted as black.
+	///
+	bool AddSamples(
+		const geometry::PointCloud<T>& points,
+		const std::vector<T>& weights = {}
+		);
+
 	///
 	/// Remove a bunch of points and optionally weights.
 	/// If no weights vector specified, all weights are assumed to be one.
@@ -118,11 +127,27 @@ public:
 	T GetWeight(const geometry::Point<T>& point) const;
 
 private:
+	///
+	/// Sample of the i-th point of either container.
+	///
+	static VoxelAvg MakeSample(
+		const std::vector<geometry::Point<T>>& points,
+		const size_t i,
+		const T weight
+		);
+
+	static VoxelAvg MakeSample(
+		const geometry::PointCloud<T>& points,
+		const size_t i,
+		const T weight
+		);
+
 	///
 	/// OpenMP parallelized generation of submaps, one for every thread
 	///
+	template <typename Points>
 	static void GenerateSubMaps(
-		const std::vector<geometry::Point<T>>& points,
+		const Points& points,
 		const std::vector<T>& weights,
 		const T voxel_size,
 		const int64_t hash_range,